@@ -167,10 +167,9 @@ namespace csyren
 
 		auto testMeshEntity = _scene.createEntity();
 		auto meshFilter = _scene.addComponent<MeshFilter>(testMeshEntity);
-		auto meshRenderer = _scene.addComponent<MeshRenderer>(testMeshEntity);
+		_scene.addComponent<Shared<MeshRenderer>>(testMeshEntity, MeshRenderer{ matHandle });
 		auto transform = _scene.addComponent<Transform>(testMeshEntity);
 		meshFilter->mesh = meshHandle;
-		meshRenderer->material = matHandle;
 
 	}
 
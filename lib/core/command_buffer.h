@@ -4,7 +4,12 @@
 #include "entity.h"
 #include "component_base.h"
 
-#include <mutex>
+#include "cstdmf/linear_arena.h"
+#include "cstdmf/per_thread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
 
 namespace csyren::core
 {
@@ -16,42 +21,237 @@ namespace csyren::core
     {
         Entity::ID   entt;
         size_t       family;
+        uint64_t     seq{ 0 };
     };
 
-    class DeferredCommands
+    struct CreateEntityCommand
+    {
+        Entity::ID id;
+        Entity::ID parent;
+    };
+
+    struct SetParentCommand
     {
+        Entity::ID entt;
+        Entity::ID parent;
+        uint64_t   seq;
+    };
+
+    struct EmplaceComponentCommand;
+    using ApplyComponentFn = void(Scene*, EmplaceComponentCommand&);
+    using DestroyPayloadFn = void(void*);
+
+    /**
+     * @brief Add/replace request; the component value lives in the command arena.
+     *
+     * `apply` is the typed playback thunk, so recording never touches scene state.
+     */
+    struct EmplaceComponentCommand
+    {
+        Entity::ID          entt;
+        size_t              family;
+        void*               payload;
+        ApplyComponentFn*   apply;
+        DestroyPayloadFn*   destroy;
+        bool                replace;
+        uint64_t            seq;
+    };
+
+    /**
+     * @brief Commands recorded by a single thread. Not synchronized.
+     */
+    class CommandStream
+    {
+        friend class DeferredCommands;
+
+        template<typename T>
+        static void destroyPayload(void* payload) { static_cast<T*>(payload)->~T(); }
     public:
-        void pushDestroyEntity(Entity::ID id)
+        CommandStream() = default;
+        ~CommandStream() { clear(); }
+
+        CommandStream(const CommandStream&) = delete;
+        CommandStream& operator=(const CommandStream&) = delete;
+
+        void pushDestroyEntity(Entity::ID id) { _destroyEntity.push_back({ id }); }
+        void pushDestroyComponent(Entity::ID entt, size_t family, uint64_t seq) { _destroyComponent.push_back({ entt, family, seq }); }
+        void pushCreateEntity(Entity::ID id, Entity::ID parent) { _createEntity.push_back({ id, parent }); }
+        void pushSetParent(Entity::ID entt, Entity::ID parent, uint64_t seq) { _setParent.push_back({ entt, parent, seq }); }
+
+        template<typename T, typename... Args>
+        void pushEmplaceComponent(uint64_t seq, Entity::ID entt, size_t family, bool replace, ApplyComponentFn* apply, Args&&... args)
+        {
+            T* payload = _arena.create<T>(std::forward<Args>(args)...);
+            _emplaceComponent.push_back({ entt, family, payload, apply,
+                std::is_trivially_destructible_v<T> ? nullptr : &destroyPayload<T>, replace, seq });
+        }
+
+        bool empty() const noexcept
+        {
+            return _destroyEntity.empty() && _destroyComponent.empty() && _createEntity.empty()
+                && _setParent.empty() && _emplaceComponent.empty();
+        }
+
+        void clear()
         {
-            std::lock_guard lock(_mutex);
-            _destroyEntity.push_back({ id });
+            for (auto& c : _emplaceComponent)
+            {
+                if (c.destroy) c.destroy(c.payload);
+            }
+            _destroyEntity.clear();
+            _destroyComponent.clear();
+            _createEntity.clear();
+            _setParent.clear();
+            _emplaceComponent.clear();
+            _arena.reset();
+            _next = 0;
         }
 
+    private:
+        uint64_t _order{ 0 };   // place among the streams that recorded since the last flush
+        uint64_t _next{ 0 };    // sequence of the next ordered command in this stream
+        std::vector<DestroyEntityCommand>  _destroyEntity;
+        std::vector<DestroyComponentCommand> _destroyComponent;
+        std::vector<CreateEntityCommand>   _createEntity;
+        std::vector<SetParentCommand>      _setParent;
+        std::vector<EmplaceComponentCommand> _emplaceComponent;
+        cstdmf::LinearArena _arena;
+    };
+
+    /**
+     * @brief Structural command buffer shared by every thread that touches a Scene.
+     *
+     * Each recording thread appends to its own CommandStream without locking and
+     * numbers its setParent and component commands itself. The only shared write is
+     * one atomic increment per thread per frame, when its stream records its first
+     * such command; that ticket orders the streams. gather() runs at the flush sync
+     * point and sorts commands by entity (and family), then by (stream ticket,
+     * sequence in stream). So commands from one thread play back in record order,
+     * and when several threads set the parent of one entity or replace the same
+     * component on it, the thread that started recording last this frame wins.
+     */
+    class DeferredCommands
+    {
+    public:
+        void pushDestroyEntity(Entity::ID id) { _streams.local().pushDestroyEntity(id); }
         void pushDestroyComponent(Entity::ID entt, size_t family)
         {
-            std::lock_guard lock(_mutex);
-            _destroyComponent.push_back({entt,family });
+            CommandStream& s = orderedStream();
+            s.pushDestroyComponent(entt, family, s._next++);
+        }
+        void pushCreateEntity(Entity::ID id, Entity::ID parent) { _streams.local().pushCreateEntity(id, parent); }
+        void pushSetParent(Entity::ID entt, Entity::ID parent)
+        {
+            CommandStream& s = orderedStream();
+            s.pushSetParent(entt, parent, s._next++);
+        }
+
+        template<typename T, typename... Args>
+        void pushEmplaceComponent(Entity::ID entt, size_t family, bool replace, ApplyComponentFn* apply, Args&&... args)
+        {
+            CommandStream& s = orderedStream();
+            s.template pushEmplaceComponent<T>(s._next++, entt, family, replace, apply, std::forward<Args>(args)...);
         }
 
-        void swap(DeferredCommands& target) 
+        /// @brief Merges every thread's stream into the playback buffers. Call only at a sync point.
+        void gather()
         {
-            std::lock_guard lock(_mutex);
-            _destroyEntity.swap(target._destroyEntity);
-            _destroyComponent.swap(target._destroyComponent);
+            _streams.forEach([this](CommandStream& s)
+                {
+                    append(_destroyEntity, s._destroyEntity);
+                    append(_destroyComponent, s._destroyComponent, s._order);
+                    append(_createEntity, s._createEntity);
+                    append(_setParent, s._setParent, s._order);
+                    append(_emplaceComponent, s._emplaceComponent, s._order);
+                });
+
+            std::sort(_createEntity.begin(), _createEntity.end(),
+                [](const auto& a, const auto& b) { return a.id < b.id; });
+            std::sort(_setParent.begin(), _setParent.end(),
+                [](const auto& a, const auto& b) { return a.entt != b.entt ? a.entt < b.entt : a.seq < b.seq; });
+            std::sort(_emplaceComponent.begin(), _emplaceComponent.end(), componentOrder<EmplaceComponentCommand, EmplaceComponentCommand>);
+            std::sort(_destroyComponent.begin(), _destroyComponent.end(), componentOrder<DestroyComponentCommand, DestroyComponentCommand>);
+            std::stable_sort(_destroyEntity.begin(), _destroyEntity.end(),
+                [](const auto& a, const auto& b) { return a.id < b.id; });
         }
 
         const auto& destroyEntityBuf() const noexcept { return _destroyEntity; }
+        const auto& createEntityBuf() const noexcept { return _createEntity; }
+        const auto& setParentBuf() const noexcept { return _setParent; }
 
-        const auto& destroyComponentBuf() const noexcept { return _destroyComponent; }
-        void clear() { _destroyEntity.clear(); _destroyComponent.clear(); }
+        /**
+         * @brief Walks add/replace and remove commands as one stream, grouped by family
+         * and entity; commands on the same entity and family come in record order.
+         */
+        template<typename OnEmplace, typename OnDestroy>
+        void forEachComponentCommand(OnEmplace&& onEmplace, OnDestroy&& onDestroy)
+        {
+            auto add = _emplaceComponent.begin();
+            auto remove = _destroyComponent.cbegin();
+            while (add != _emplaceComponent.end() || remove != _destroyComponent.cend())
+            {
+                if (remove == _destroyComponent.cend() || (add != _emplaceComponent.end() && componentOrder(*add, *remove)))
+                    onEmplace(*add++);
+                else
+                    onDestroy(*remove++);
+            }
+        }
+
+        void clear()
+        {
+            _streams.forEach([](CommandStream& s) { s.clear(); });
+            _destroyEntity.clear();
+            _destroyComponent.clear();
+            _createEntity.clear();
+            _setParent.clear();
+            _emplaceComponent.clear();
+            _streamOrder.store(0, std::memory_order_relaxed);
+        }
 
     private:
+        template<typename A, typename B>
+        static bool componentOrder(const A& a, const B& b) noexcept
+        {
+            if (a.family != b.family) return a.family < b.family;
+            return a.entt != b.entt ? a.entt < b.entt : a.seq < b.seq;
+        }
+
+        // the low bits of a gathered `seq` are the sequence in its stream, the high bits the stream ticket
+        static constexpr unsigned kStreamShift = 40;
+
+        CommandStream& orderedStream()
+        {
+            CommandStream& s = _streams.local();
+            if (s._next == 0)
+                s._order = _streamOrder.fetch_add(1, std::memory_order_relaxed);
+            return s;
+        }
+
+        template<typename Command>
+        static void append(std::vector<Command>& to, const std::vector<Command>& from, uint64_t order)
+        {
+            const size_t first = to.size();
+            append(to, from);
+            for (size_t i = first; i < to.size(); ++i)
+                to[i].seq |= order << kStreamShift;
+        }
+
+        template<typename Command>
+        static void append(std::vector<Command>& to, const std::vector<Command>& from)
+        {
+            to.insert(to.end(), from.begin(), from.end());
+        }
+
+        cstdmf::PerThread<CommandStream> _streams;
+        std::atomic<uint64_t> _streamOrder{ 0 };
+
         std::vector<DestroyEntityCommand>  _destroyEntity;
         std::vector<DestroyComponentCommand> _destroyComponent;
-        std::mutex _mutex;
+        std::vector<CreateEntityCommand>   _createEntity;
+        std::vector<SetParentCommand>      _setParent;
+        std::vector<EmplaceComponentCommand> _emplaceComponent;
     };
 }
 
 
 #endif
-
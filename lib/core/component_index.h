@@ -0,0 +1,134 @@
+#ifndef __CSYREN_COMPONENT_INDEX__
+#define __CSYREN_COMPONENT_INDEX__
+
+#include "entity.h"
+#include "component_pool.h"
+#include "observer.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+
+namespace csyren::core
+{
+	class IndexBase
+	{
+		friend class Scene;
+	public:
+		virtual ~IndexBase() = default;
+
+		[[nodiscard]] size_t family() const noexcept { return _family; }
+
+	protected:
+		explicit IndexBase(size_t family) noexcept : _family(family) {}
+
+		virtual void onEvent(Entity::ID id, ObserveOn event) = 0;
+
+	private:
+		size_t _family;
+	};
+
+	/**
+	 * @brief Ordered secondary index over a value extracted from component `T`.
+	 *
+	 * Created by Scene::createIndex and kept up to date on add, remove, replace and
+	 * markChanged()/patch(). Writes through a plain reference are not seen until the
+	 * component is marked changed. Disabled and sleeping entities stay indexed.
+	 */
+	template<typename T, typename Extract>
+	class ComponentIndex final : public IndexBase
+	{
+		friend class Scene;
+	public:
+		using Key = std::decay_t<std::invoke_result_t<Extract&, const T&>>;
+	private:
+		using Map = std::multimap<Key, Entity::ID>;
+	public:
+		ComponentIndex(size_t family, std::shared_ptr<ComponentPool<T>> pool, Extract extract)
+			: IndexBase(family), _pool(std::move(pool)), _extract(std::move(extract))
+		{
+			for (auto it = _pool->key_begin(); it != _pool->key_end(); ++it)
+				insert(*it, (*_pool)[*it]);
+		}
+
+		/// @brief Calls `fn(Entity::ID)` for every entity whose key equals `key`.
+		template<typename Fn>
+		void each(const Key& key, Fn&& fn) const
+		{
+			auto [first, last] = _byKey.equal_range(key);
+			for (; first != last; ++first)
+				fn(first->second);
+		}
+
+		/// @brief Calls `fn(const Key&, Entity::ID)` for keys in [lo, hi], in key order.
+		template<typename Fn>
+		void range(const Key& lo, const Key& hi, Fn&& fn) const
+		{
+			auto last = _byKey.upper_bound(hi);
+			for (auto it = _byKey.lower_bound(lo); it != last; ++it)
+				fn(it->first, it->second);
+		}
+
+		/// @brief Calls `fn(const Key&, Entity::ID)` for every indexed entity, in key order.
+		template<typename Fn>
+		void each(Fn&& fn) const
+		{
+			for (const auto& [key, id] : _byKey)
+				fn(key, id);
+		}
+
+		[[nodiscard]] size_t count(const Key& key) const { return _byKey.count(key); }
+		[[nodiscard]] size_t size() const noexcept { return _byKey.size(); }
+
+		/// @brief Key currently recorded for `id`, or nullptr if it is not indexed.
+		[[nodiscard]] const Key* keyOf(Entity::ID id) const
+		{
+			auto it = _byEntity.find(id);
+			return it != _byEntity.end() ? &it->second->first : nullptr;
+		}
+
+	protected:
+		void onEvent(Entity::ID id, ObserveOn event) override
+		{
+			if (event == ObserveOn::Removed)
+			{
+				erase(id);
+				return;
+			}
+			if (const T* comp = _pool->try_get(id))
+				insert(id, *comp);
+		}
+
+	private:
+		void insert(Entity::ID id, const T& comp)
+		{
+			Key key = std::invoke(_extract, comp);
+			auto found = _byEntity.find(id);
+			if (found != _byEntity.end())
+			{
+				if (!(found->second->first < key) && !(key < found->second->first)) return;
+				_byKey.erase(found->second);
+				found->second = _byKey.emplace(std::move(key), id);
+				return;
+			}
+			_byEntity.emplace(id, _byKey.emplace(std::move(key), id));
+		}
+
+		void erase(Entity::ID id)
+		{
+			auto found = _byEntity.find(id);
+			if (found == _byEntity.end()) return;
+			_byKey.erase(found->second);
+			_byEntity.erase(found);
+		}
+
+		std::shared_ptr<ComponentPool<T>> _pool;
+		Extract _extract;
+		Map _byKey;
+		std::unordered_map<Entity::ID, typename Map::iterator> _byEntity;
+	};
+}
+
+#endif
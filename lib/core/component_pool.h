@@ -1,3 +1,4 @@
+
 #ifndef  __CSYREN_COMPONENT_POOL__
 #define	 __CSYREN_COMPONENT_POOL__
 #include "component_base.h"
@@ -6,15 +7,206 @@
 #include "cstdmf/page_view.h"
 #include "cstdmf/sparse_set.h"
 
+#include <type_traits>
+
 namespace csyren::core
 {
+    /**
+     * @brief Type-erased face of a component pool, used by runtime queries and tooling.
+     */
     struct PoolBase
     {
         virtual ~PoolBase() = default;
+
+        /// Moves `entity` between the active prefix and the inactive tail of the pool.
+        virtual void setActive(Entity::ID entity, bool active) = 0;
+
+        [[nodiscard]] virtual size_t poolSize() const noexcept = 0;
+        /// Entities in [0, poolActiveSize()) of poolKeys() are enabled and awake.
+        [[nodiscard]] virtual size_t poolActiveSize() const noexcept = 0;
+        [[nodiscard]] virtual const Entity::ID* poolKeys() const noexcept = 0;
+
+        /// Component of `entity` or nullptr. Tag pools return a shared dummy instance.
+        [[nodiscard]] virtual void* poolGet(Entity::ID entity) noexcept = 0;
+        /// Component stored at dense position `index` (< poolSize()).
+        [[nodiscard]] virtual void* poolAt(size_t index) noexcept = 0;
+        /// sizeof the component, 0 for tags.
+        [[nodiscard]] virtual size_t componentSize() const noexcept = 0;
     };
 
+    /**
+     * @brief Keeps components of active entities packed at the front of the dense arrays.
+     *
+     * [0, active_size()) holds active entities, the rest belongs to disabled or sleeping
+     * ones. While a pool has no inactive entries every operation costs the same as the
+     * plain storage; otherwise add/remove/toggle pay at most one extra swap.
+     */
+    template<class Storage>
+    class PartitionedStorage : public Storage
+    {
+    public:
+        [[nodiscard]] size_t active_size() const noexcept { return _activeEnd; }
+
+        [[nodiscard]] auto active_key_end() const noexcept { return this->key_begin() + _activeEnd; }
+
+        [[nodiscard]] bool is_active(Entity::ID entity) const noexcept
+        {
+            return this->index_of(entity) < _activeEnd;
+        }
+
+        bool erase(Entity::ID entity)
+        {
+            const size_t idx = this->index_of(entity);
+            if (idx == this->size()) return false;
+
+            if (idx < _activeEnd)
+            {
+                // move the hole to the active/inactive boundary before swap-and-pop
+                this->swap_dense(idx, _activeEnd - 1);
+                --_activeEnd;
+            }
+            return Storage::erase(entity);
+        }
+
+        void activate(Entity::ID entity)
+        {
+            const size_t idx = this->index_of(entity);
+            if (idx == this->size() || idx < _activeEnd) return;
+            this->swap_dense(idx, _activeEnd);
+            ++_activeEnd;
+        }
+
+        void deactivate(Entity::ID entity)
+        {
+            const size_t idx = this->index_of(entity);
+            if (idx >= _activeEnd) return;
+            this->swap_dense(idx, _activeEnd - 1);
+            --_activeEnd;
+        }
+
+        void clear()
+        {
+            Storage::clear();
+            _activeEnd = 0;
+        }
+
+        /// @brief Sorts the active and inactive ranges separately, keeping the partition.
+        template<typename Compare>
+        void sort(Compare compare)
+        {
+            Storage::sort(compare, 0, _activeEnd);
+            Storage::sort(compare, _activeEnd, this->size());
+        }
+
+    protected:
+        /// @brief Moves elements appended at [first, size()) into the active prefix.
+        void adoptFrom(size_t first)
+        {
+            for (size_t i = first; i < this->size(); ++i)
+            {
+                this->swap_dense(i, _activeEnd);
+                ++_activeEnd;
+            }
+        }
+
+        void adoptLast() { adoptFrom(this->size() - 1); }
+
+    private:
+        size_t _activeEnd{ 0 };
+    };
+
+    /// @brief PoolBase plumbing shared by every ComponentPool flavour.
+    template<class Storage>
+    class PoolStorage : public PoolBase, public PartitionedStorage<Storage>
+    {
+    public:
+        void setActive(Entity::ID entity, bool active) override
+        {
+            active ? this->activate(entity) : this->deactivate(entity);
+        }
+
+        [[nodiscard]] size_t poolSize() const noexcept override { return this->size(); }
+        [[nodiscard]] size_t poolActiveSize() const noexcept override { return this->active_size(); }
+        [[nodiscard]] const Entity::ID* poolKeys() const noexcept override { return this->key_data(); }
+    };
+
+    template<class T, bool = std::is_empty_v<T>>
+    class ComponentPool : public PoolStorage<cstdmf::SparseSet<T>>
+    {
+        using Storage = PartitionedStorage<cstdmf::SparseSet<T>>;
+    public:
+        template<typename... Args>
+        T* emplace(Entity::ID entity, Args&&... args)
+        {
+            Storage::emplace(entity, std::forward<Args>(args)...);
+            this->adoptLast();
+            return this->try_get(entity);
+        }
+
+        template<typename Remap>
+        void append(ComponentPool&& other, Remap&& remap)
+        {
+            const size_t first = this->size();
+            cstdmf::SparseSet<T>::append(std::move(other), std::forward<Remap>(remap));
+            other.clear();
+            this->adoptFrom(first);
+        }
+
+        [[nodiscard]] void* poolGet(Entity::ID entity) noexcept override { return this->try_get(entity); }
+        [[nodiscard]] void* poolAt(size_t index) noexcept override { return this->data() + index; }
+        [[nodiscard]] size_t componentSize() const noexcept override { return sizeof(T); }
+    };
+
+    /**
+     * @brief Pool for tag components (empty types): stores only entity keys.
+     *
+     * Every entity shares one instance, so pointers handed out are never dereferenced
+     * for data and stay valid for the life of the program.
+     */
     template<class T>
-    class ComponentPool : public PoolBase,public cstdmf::SparseSet<T>{};
+    class ComponentPool<T, true> : public PoolStorage<cstdmf::SparseSet<void, Entity::ID>>
+    {
+        using Keys = cstdmf::SparseSet<void, Entity::ID>;
+        using Storage = PartitionedStorage<Keys>;
+    public:
+        template<typename... Args>
+        T* emplace(Entity::ID entity, Args&&...)
+        {
+            Keys::emplace(entity);
+            this->adoptLast();
+            return &_instance;
+        }
+
+        [[nodiscard]] T* try_get(Entity::ID entity) noexcept { return this->contains(entity) ? &_instance : nullptr; }
+        [[nodiscard]] const T* try_get(Entity::ID entity) const noexcept { return this->contains(entity) ? &_instance : nullptr; }
+
+        [[nodiscard]] T& operator[](Entity::ID entity)
+        {
+            if (!this->contains(entity)) throw std::out_of_range("ComponentPool::[]");
+            return _instance;
+        }
+        [[nodiscard]] const T& operator[](Entity::ID entity) const
+        {
+            if (!this->contains(entity)) throw std::out_of_range("ComponentPool::[]");
+            return _instance;
+        }
+
+        template<typename Remap>
+        void append(ComponentPool&& other, Remap&& remap)
+        {
+            const size_t first = this->size();
+            Keys::append(std::move(other), std::forward<Remap>(remap));
+            other.clear();
+            this->adoptFrom(first);
+        }
+
+        [[nodiscard]] void* poolGet(Entity::ID entity) noexcept override { return try_get(entity); }
+        [[nodiscard]] void* poolAt(size_t) noexcept override { return &_instance; }
+        [[nodiscard]] size_t componentSize() const noexcept override { return 0; }
+
+    private:
+        static inline T _instance{};
+    };
 
 }
 
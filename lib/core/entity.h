@@ -5,6 +5,7 @@
 #include <bitset>
 
 #include "component_base.h"
+#include "cstdmf/relocatable.h"
 
 namespace csyren::core
 {
@@ -19,3 +20,8 @@ namespace csyren::core
 		std::bitset<reflection::MAX_COMPONENT_TYPES> components;
 	};
 }
+
+// members are a std::vector and a std::bitset; keep it that way or drop the opt-in
+template<>
+struct csyren::cstdmf::is_trivially_relocatable<csyren::core::Entity>
+	: std::bool_constant<CSYREN_STD_VECTOR_RELOCATABLE> {};
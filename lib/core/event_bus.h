@@ -3,7 +3,13 @@
 #define __CSYREN_EVENT_BUS__
 
 #include "family_generator.h"
+#include "event_marker.h"
+#include "event_recorder.h"
+#include "cstdmf/delegate.h"
+#include "cstdmf/job_system.h"
 #include "cstdmf/log.h"
+#include "cstdmf/per_thread.h"
+#include "cstdmf/sparse_set.h"
 
 #include <vector>
 #include <array>
@@ -13,9 +19,19 @@
 #include <memory>
 #include <optional>
 #include <shared_mutex>
+#include <span>
 #include <algorithm>
 #include <type_traits>
+#include <unordered_map>
+#include <atomic>
+#include <stdexcept>
 #include <cstdint>
+#include <chrono>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <typeinfo>
 
 namespace csyren::core::reflection
 {
@@ -26,8 +42,6 @@ namespace csyren::core::reflection
 
 namespace csyren::core::events
 {
-	using EventMarker = uint32_t;
-
 	static constexpr uint32_t MAX_GENERATION = std::numeric_limits<uint32_t>::max();
     constexpr uint64_t INVALID_TOKEN = 0xFFFFFFFFFFFFFFFFull;
 	class PublishToken
@@ -50,7 +64,8 @@ namespace csyren::core::events
 	{
 
 		friend class EventBus2;
-		explicit SubscriberToken(uint64_t d) : _data(d) {}
+		// _data = event type id << 32 | subscriber slot inside that type
+		explicit SubscriberToken(uint64_t d, uint32_t generation = 0) : _data(d), _generation(generation) {}
 
 	public:
 		SubscriberToken() noexcept = default;
@@ -60,13 +75,234 @@ namespace csyren::core::events
         }
     private:
 		uint64_t _data{ INVALID_TOKEN };
+		uint32_t _generation{ MAX_GENERATION };
+	};
+
+	using EventEntity = uint32_t;
+
+	/**
+	 * @brief Tells EventBus2 which entity an event is about (for subscribe_entity).
+	 *
+	 * Events with an `entity` member work out of the box; specialize with a static
+	 * `get(const Event_t&)` for events that name it differently.
+	 */
+	template<typename Event_t, typename = void>
+	struct event_entity {};
+
+	template<typename Event_t>
+	struct event_entity<Event_t, std::void_t<decltype(std::declval<const Event_t&>().entity)>>
+	{
+		static EventEntity get(const Event_t& event) noexcept { return static_cast<EventEntity>(event.entity); }
+	};
+
+	template<typename Event_t, typename = void>
+	inline constexpr bool has_event_entity_v = false;
+	template<typename Event_t>
+	inline constexpr bool has_event_entity_v<Event_t, std::void_t<decltype(&event_entity<Event_t>::get)>> = true;
+
+	namespace details
+	{
+		/**
+		 * @brief Pending-event queue with one buffer per publishing thread.
+		 *
+		 * push() only takes the calling thread's own buffer lock, so producers never
+		 * wait for each other; the lock is contended only while drain() swaps the
+		 * buffer out. Buffers are double-buffered and keep their capacity, so
+		 * steady-state publishing does not allocate and draining never copies.
+		 * Events are stored bare; markers are kept as runs, one entry per change
+		 * of marker (or of the nested flag, see EventBus2) rather than an optional
+		 * per event. Order is preserved per thread.
+		 */
+		template<typename Event_t>
+		class EventQueue
+		{
+			struct MarkerRun
+			{
+				uint32_t end;	// one past the run's last event
+				EventMarker marker;
+				bool marked;
+				bool nested;	// published from inside a dispatch
+			};
+
+			struct Events
+			{
+				std::vector<Event_t> events;
+				std::vector<MarkerRun> runs;
+
+				void clear() noexcept
+				{
+					events.clear();
+					runs.clear();
+				}
+			};
+
+			struct Buffer
+			{
+				std::mutex mutex;
+				Events pending;
+				Events draining;
+			};
+		public:
+			template<typename E>
+			void push(E&& event, const std::optional<EventMarker>& marker, bool nested)
+			{
+				Buffer& buffer = buffers_.local();
+				std::lock_guard lock(buffer.mutex);
+				buffer.pending.events.push_back(std::forward<E>(event));
+				extend_run(buffer.pending, marker, nested);
+			}
+
+			/// @brief Appends a whole batch under one lock and a single marker run.
+			void push(std::span<const Event_t> events, const std::optional<EventMarker>& marker, bool nested)
+			{
+				if (events.empty()) return;
+				Buffer& buffer = buffers_.local();
+				std::lock_guard lock(buffer.mutex);
+				buffer.pending.events.insert(buffer.pending.events.end(), events.begin(), events.end());
+				extend_run(buffer.pending, marker, nested);
+			}
+
+			/**
+			 * @brief Takes everything published so far and calls `fn(Event_t&, const std::optional<EventMarker>&, bool nested)`.
+			 *
+			 * Events pushed while `fn` runs (also from `fn` itself) wait for the next drain().
+			 */
+			/// @return number of events handed to `fn`
+			template<typename Fn>
+			size_t drain(Fn&& fn)
+			{
+				size_t drained = 0;
+				buffers_.forEach([this](Buffer& buffer)
+					{
+						std::lock_guard lock(buffer.mutex);
+						if (buffer.pending.events.empty()) return;
+						std::swap(buffer.pending, buffer.draining);
+						draining_.push_back(&buffer);
+					});
+				for (Buffer* buffer : draining_)
+				{
+					auto& events = buffer->draining;
+					size_t i = 0;
+					for (const MarkerRun& run : events.runs)
+					{
+						const std::optional<EventMarker> marker = run.marked ? std::optional<EventMarker>(run.marker) : std::nullopt;
+						for (; i < run.end; ++i)
+							fn(events.events[i], marker, run.nested);
+					}
+					drained += events.events.size();
+					events.clear();
+				}
+				draining_.clear();
+				return drained;
+			}
+
+		private:
+			static void extend_run(Events& events, const std::optional<EventMarker>& marker, bool nested)
+			{
+				const uint32_t end = static_cast<uint32_t>(events.events.size());
+				if (!events.runs.empty())
+				{
+					MarkerRun& last = events.runs.back();
+					if (last.marked == marker.has_value() && (!last.marked || last.marker == *marker) && last.nested == nested)
+					{
+						last.end = end;
+						return;
+					}
+				}
+				events.runs.push_back({ end, marker.value_or(0), marker.has_value(), nested });
+			}
+
+			cstdmf::PerThread<Buffer> buffers_;
+			std::vector<Buffer*> draining_;
+		};
+
+		/**
+		 * @brief Index -> T table that allocates fixed pages on first use.
+		 *
+		 * find() is lock-free and never sees a page being built; ensure() creates
+		 * missing pages under the table's mutex. Elements never move.
+		 */
+		template<typename T, size_t PageSize, size_t MaxPages>
+		class PagedTable
+		{
+			using Page = std::array<T, PageSize>;
+		public:
+			static constexpr size_t kCapacity = PageSize * MaxPages;
+
+			PagedTable() = default;
+			~PagedTable()
+			{
+				for (auto& page : pages_)
+					delete page.load(std::memory_order_relaxed);
+			}
+
+			PagedTable(const PagedTable&) = delete;
+			PagedTable& operator=(const PagedTable&) = delete;
+
+			/// @brief Element `index`, or nullptr if its page was never created.
+			[[nodiscard]] T* find(size_t index) noexcept
+			{
+				if (index >= kCapacity) return nullptr;
+				Page* page = pages_[index / PageSize].load(std::memory_order_acquire);
+				return page ? &(*page)[index % PageSize] : nullptr;
+			}
+
+			/// @brief Element `index`, creating its page; `index` must be below kCapacity.
+			T& ensure(size_t index)
+			{
+				if (T* found = find(index)) return *found;
+
+				std::lock_guard lock(mutex_);
+				auto& slot = pages_[index / PageSize];
+				Page* page = slot.load(std::memory_order_relaxed);
+				if (!page)
+				{
+					page = new Page{};
+					slot.store(page, std::memory_order_release);
+				}
+				return (*page)[index % PageSize];
+			}
+
+		private:
+			std::array<std::atomic<Page*>, MaxPages> pages_{};
+			std::mutex mutex_;
+		};
+	}
+
+	/// How published events of a type reach their subscribers (EventBus2::set_delivery).
+	enum class Delivery
+	{
+		Batched,	///< queued and delivered by commit_batch (default)
+		Immediate	///< delivered inside publish(), on the publishing thread, without a copy
+	};
+
+	/**
+	 * @brief Counters of one event type, see EventBus2::set_stats_enabled.
+	 *
+	 * "last batch" values belong to the most recent commit_batch and are zero for
+	 * types that had no traffic in it. Nothing is counted while stats are off.
+	 * Callback times are exclusive: an immediate event published from a callback
+	 * is timed for its own type only, not again for the type being dispatched.
+	 */
+	struct EventTypeStats
+	{
+		std::string_view name;		///< typeid name, for display only
+		uint64_t type_id{ 0 };
+		uint64_t published_last_batch{ 0 };
+		uint64_t delivered_last_batch{ 0 };	///< subscriber callbacks invoked
+		double callback_ms_last_batch{ 0.0 };
+		uint64_t published_total{ 0 };
+		uint64_t delivered_total{ 0 };
+		double callback_ms_total{ 0.0 };
+		uint64_t peak_pending{ 0 };		///< most events queued for one commit
 	};
 
 	class EventBus2
 	{
 	public:
+		// small callables are stored inline without allocating; see cstdmf::Delegate
 		template<class Event_t>
-		using Callback_t = std::function<void(std::decay_t<Event_t>&)>;
+		using Callback_t = cstdmf::Delegate<void(std::decay_t<Event_t>&)>;
 		
 		//    
 		struct PublisherRecord {
@@ -76,105 +312,403 @@ namespace csyren::core::events
 		};
 
 		// ---      ---
+		// written by the committing (or immediate-publishing) thread, except `published`
+		struct TypeCounters {
+			std::atomic<uint64_t> published{ 0 };
+			uint64_t delivered{ 0 };
+			uint64_t callback_ns{ 0 };
+			uint64_t peak_pending{ 0 };
+
+			uint64_t batch{ 0 };	// commit_batch the last_* values belong to
+			uint64_t last_published{ 0 }, last_delivered{ 0 }, last_callback_ns{ 0 };
+			uint64_t seen_published{ 0 }, seen_delivered{ 0 }, seen_callback_ns{ 0 };
+
+			void close_batch(uint64_t index) {
+				const uint64_t total = published.load(std::memory_order_relaxed);
+				last_published = total - std::exchange(seen_published, total);
+				last_delivered = delivered - std::exchange(seen_delivered, delivered);
+				last_callback_ns = callback_ns - std::exchange(seen_callback_ns, callback_ns);
+				batch = index;
+			}
+		};
+
 		struct EventDataWrapper {
+			EventDataWrapper(uint64_t type_id, std::string_view name) : type_id_(type_id), name_(name) {}
 			virtual ~EventDataWrapper() = default;
-			virtual void publish(void* event, std::optional<EventMarker> marker) = 0;
-			virtual void commit() = 0;
-			virtual void unsubscribe(uint64_t sub_id) = 0;
+			// returns the number of queued events it delivered; each is recorded first if `recorder` is set,
+			// and the callbacks run are added to counters_ if `stats`
+			virtual size_t commit(EventRecorder* recorder, bool stats) = 0;
+			// true if the token still named a live subscriber
+			virtual bool unsubscribe(uint32_t slot, uint32_t generation) = 0;
 			virtual void cleanup_subscribers() = 0;
+
+			// set while the type sits in the bus' dirty / cleanup list
+			std::atomic<bool> queued_{ false };
+			bool needs_cleanup_{ false };
+			std::atomic<bool> immediate_{ false };
+			std::atomic<bool> thread_safe_{ false };
+
+			const uint64_t type_id_;
+			const std::string_view name_;
+			TypeCounters counters_;
 		};
 
 		template<typename Event_t>
 		struct EventData : public EventDataWrapper {
+			EventData() : EventDataWrapper(reflection::EventFamily::getID<Event_t>(), typeid(Event_t).name()) {}
+
 			struct Subscriber {
-				uint64_t id;
+				uint32_t slot;
 				Callback_t<Event_t> callback;
 				std::optional<EventMarker> marker;
+				int priority{ 0 };
 				bool active{ true };
 			};
 
-			struct EventInstance {
-				Event_t event;
-				std::optional<EventMarker> marker;
-			};
-
-			std::vector<Subscriber> subscribers_;
+			std::vector<Subscriber> subscribers_;	// by priority (higher first), then subscription order
 			mutable std::shared_mutex subscribers_mutex_;
+			uint32_t dispatch_depth_{ 0 };
+			// subscriptions made by callbacks, global and per-entity: appending mid-dispatch
+			// would move the subscribers (and their inline callbacks) under the running loop
+			std::vector<Subscriber> deferred_subscribers_;
+
+			// positions in subscribers_, ascending: marked events visit only wildcard + their bucket
+			std::vector<uint32_t> wildcard_;
+			std::unordered_map<EventMarker, std::vector<uint32_t>> marked_;
 
-			std::vector<EventInstance> pending_events_;
-			std::mutex events_mutex_;
+			// entity-scoped subscribers: commit looks up only the event's own entity
+			cstdmf::SparseSet<std::vector<Subscriber>, EventEntity> entity_subscribers_;
+			std::vector<EventEntity> dirty_entities_;
+
+			// token slot -> current position of the subscriber, so unsubscribe is a direct tombstone
+			struct Slot {
+				uint32_t generation{ 0 };
+				uint32_t index{ 0 };
+				EventEntity entity{ 0 };
+				bool scoped{ false };
+				bool live{ false };
+				bool deferred{ false };	// still in deferred_subscribers_
+			};
+			std::vector<Slot> slots_;
+			std::vector<uint32_t> free_slots_;
+			std::vector<uint32_t> released_slots_;	// reusable once cleanup erased their subscriber
+
+			details::EventQueue<Event_t> pending_events_;
 
 			// ---   ---
 
-			void publish(void* event, std::optional<EventMarker> marker) override {
-				std::lock_guard lock(events_mutex_);
-				pending_events_.push_back({ *static_cast<Event_t*>(event), marker });
+			template<typename E>
+			void publish(E&& event, const std::optional<EventMarker>& marker, bool nested) {
+				pending_events_.push(std::forward<E>(event), marker, nested);
 			}
 
-			void commit() override {
-				std::vector<EventInstance> events_to_process;
+			size_t commit(EventRecorder* recorder, bool stats) override {
+				size_t delivered = 0;
+				const size_t drained = pending_events_.drain([this, recorder, &delivered](Event_t& event, const std::optional<EventMarker>& marker, bool nested)
 				{
-					std::lock_guard lock(events_mutex_);
-					if (pending_events_.empty()) return;
-					events_to_process.swap(pending_events_);
-				}
-				for (const auto& instance : events_to_process) 
+					// recorded in delivery order, before callbacks can modify the event
+					if (recorder) recorder->record(static_cast<const Event_t&>(event), marker, nested);
+					delivered += dispatch(event, marker);
+				});
+				if (stats) counters_.delivered += delivered;
+				return drained;
+			}
+
+			/// @brief Delivers one event to every matching subscriber; shared by commit and immediate publish.
+			/// @return number of callbacks invoked
+			size_t dispatch(Event_t& event, const std::optional<EventMarker>& marker)
+			{
+				size_t delivered = 0;
+				++dispatch_depth_;
+				if (!marker.has_value() || marked_.empty())
 				{
-					for (auto& sub : subscribers_) 
-					{ // Iterate by reference
-						// Check for active status and marker match
-						if (sub.active) 
+					// every subscriber matches; new subscriptions wait in deferred_subscribers_
+					for (size_t i = 0; i < subscribers_.size(); ++i)
+					{
+						if (subscribers_[i].active)
 						{
-							if (instance.marker.has_value() && sub.marker.has_value() && instance.marker != sub.marker)
-							{
-								continue;
-							}
-							sub.callback(const_cast<Event_t&>(instance.event));
+							++delivered;
+							subscribers_[i].callback(event);
 						}
 					}
 				}
+				else
+				{
+					delivered += dispatch_marked(event, *marker);
+				}
+				if constexpr (has_event_entity_v<Event_t>)
+				{
+					if (!entity_subscribers_.empty())
+						delivered += dispatch_entity(event, marker);
+				}
+				if (--dispatch_depth_ == 0 && !deferred_subscribers_.empty())
+					add_deferred_subscribers();
+				return delivered;
+			}
+
+			// merges the wildcard and marker buckets so subscription order is kept
+			size_t dispatch_marked(Event_t& event, EventMarker marker)
+			{
+				static const std::vector<uint32_t> kNone;
+				auto bucket = marked_.find(marker);
+				const auto& marked = bucket != marked_.end() ? bucket->second : kNone;
+
+				size_t delivered = 0;
+				size_t w = 0, m = 0;
+				while (w < wildcard_.size() || m < marked.size())
+				{
+					uint32_t index;
+					if (m == marked.size() || (w < wildcard_.size() && wildcard_[w] < marked[m]))
+						index = wildcard_[w++];
+					else
+						index = marked[m++];
+					if (subscribers_[index].active)
+					{
+						++delivered;
+						subscribers_[index].callback(event);
+					}
+				}
+				return delivered;
+			}
+
+			void index_subscriber(uint32_t index)
+			{
+				const auto& marker = subscribers_[index].marker;
+				if (marker.has_value()) marked_[*marker].push_back(index);
+				else wildcard_.push_back(index);
+			}
+
+			size_t dispatch_entity(Event_t& event, const std::optional<EventMarker>& marker)
+			{
+				auto* subs = entity_subscribers_.try_get(event_entity<Event_t>::get(event));
+				if (!subs) return 0;
+				size_t delivered = 0;
+				for (size_t i = 0; i < subs->size(); ++i)
+				{
+					auto& sub = (*subs)[i];
+					if (!sub.active) continue;
+					if (marker.has_value() && sub.marker.has_value() && marker != sub.marker)
+						continue;
+					++delivered;
+					sub.callback(event);
+				}
+				return delivered;
+			}
+
+			// stable: equal priorities keep subscription order
+			void sort_subscribers()
+			{
+				std::stable_sort(subscribers_.begin(), subscribers_.end(),
+					[](const Subscriber& a, const Subscriber& b) { return a.priority > b.priority; });
+				reindex_subscribers();
+			}
+
+			void reindex_subscribers()
+			{
+				wildcard_.clear();
+				marked_.clear();
+				for (uint32_t i = 0; i < subscribers_.size(); ++i)
+				{
+					slots_[subscribers_[i].slot].index = i;
+					index_subscriber(i);
+				}
 			}
 
-			void unsubscribe(uint64_t sub_id) override {
+			bool unsubscribe(uint32_t slot_index, uint32_t generation) override {
 				std::unique_lock lock(subscribers_mutex_);
-				auto it = std::find_if(subscribers_.begin(), subscribers_.end(),
-					[sub_id](const Subscriber& s) { return s.id == sub_id; });
-				if (it != subscribers_.end()) 
+				if (slot_index >= slots_.size()) return false;
+				Slot& slot = slots_[slot_index];
+				if (!slot.live || slot.generation != generation) return false;
+
+				if (slot.deferred)
 				{
+					auto it = std::find_if(deferred_subscribers_.begin(), deferred_subscribers_.end(),
+						[slot_index](const Subscriber& s) { return s.slot == slot_index; });
 					it->active = false;
 				}
+				else if (slot.scoped)
+				{
+					(*entity_subscribers_.try_get(slot.entity))[slot.index].active = false;
+					dirty_entities_.push_back(slot.entity);
+				}
+				else
+				{
+					subscribers_[slot.index].active = false;
+				}
+				slot.live = false;
+				slot.generation = slot.generation >= MAX_GENERATION - 1 ? 0 : slot.generation + 1;
+				released_slots_.push_back(slot_index);
+				return true;
+			}
+
+			std::pair<uint32_t, uint32_t> subscribe_entity(EventEntity entity, Callback_t<Event_t>&& callback, std::optional<EventMarker> marker) {
+				std::unique_lock lock(subscribers_mutex_);
+				const uint32_t slot = acquire_slot(0, entity, true);
+				Subscriber subscriber{ slot, std::move(callback), marker };
+				if (dispatch_depth_ != 0)
+				{
+					// dispatch_entity is walking one of these vectors, and emplacing may grow the set
+					slots_[slot].deferred = true;
+					deferred_subscribers_.push_back(std::move(subscriber));
+				}
+				else
+				{
+					append_entity_subscriber(entity, std::move(subscriber));
+				}
+				return { slot, slots_[slot].generation };
+			}
+
+			void append_entity_subscriber(EventEntity entity, Subscriber&& subscriber)
+			{
+				auto* subs = entity_subscribers_.try_get(entity);
+				if (!subs) subs = entity_subscribers_.emplace(entity);
+				slots_[subscriber.slot].index = static_cast<uint32_t>(subs->size());
+				subs->push_back(std::move(subscriber));
 			}
 
-			uint64_t subscribe(Callback_t<Event_t>&& callback, std::optional<EventMarker> marker) {
-				const uint64_t sub_id = next_subscriber_id_++;
+			/// @brief Returns the token's {slot, generation}.
+			std::pair<uint32_t, uint32_t> subscribe(Callback_t<Event_t>&& callback, std::optional<EventMarker> marker, int priority) {
 				std::unique_lock lock(subscribers_mutex_);
-				subscribers_.push_back({ sub_id, std::move(callback), marker });
-				return sub_id;
+				const uint32_t slot = acquire_slot(static_cast<uint32_t>(subscribers_.size()), 0, false);
+				Subscriber subscriber{ slot, std::move(callback), marker, priority };
+				if (dispatch_depth_ != 0)
+				{
+					// joins once the outermost dispatch returns, i.e. from the next event on
+					slots_[slot].deferred = true;
+					deferred_subscribers_.push_back(std::move(subscriber));
+				}
+				else
+				{
+					append_subscriber(std::move(subscriber));
+				}
+				return { slot, slots_[slot].generation };
+			}
+
+			void append_subscriber(Subscriber&& subscriber)
+			{
+				const bool in_order = subscribers_.empty() || subscribers_.back().priority >= subscriber.priority;
+				slots_[subscriber.slot].index = static_cast<uint32_t>(subscribers_.size());
+				subscribers_.push_back(std::move(subscriber));
+				if (in_order) index_subscriber(static_cast<uint32_t>(subscribers_.size() - 1));
+				else sort_subscribers();
+			}
+
+			void add_deferred_subscribers()
+			{
+				auto deferred = std::move(deferred_subscribers_);
+				deferred_subscribers_.clear();
+				for (Subscriber& subscriber : deferred)
+				{
+					// unsubscribed before it joined: its slot is already released
+					if (!subscriber.active) continue;
+					Slot& slot = slots_[subscriber.slot];
+					slot.deferred = false;
+					if (slot.scoped) append_entity_subscriber(slot.entity, std::move(subscriber));
+					else append_subscriber(std::move(subscriber));
+				}
+			}
+
+			uint32_t acquire_slot(uint32_t index, EventEntity entity, bool scoped)
+			{
+				uint32_t slot;
+				if (!free_slots_.empty())
+				{
+					slot = free_slots_.back();
+					free_slots_.pop_back();
+				}
+				else
+				{
+					slot = static_cast<uint32_t>(slots_.size());
+					slots_.emplace_back();
+				}
+				Slot& record = slots_[slot];
+				record.index = index;
+				record.entity = entity;
+				record.scoped = scoped;
+				record.live = true;
+				record.deferred = false;
+				return slot;
 			}
 
 			void cleanup_subscribers() override 
 			{
 				std::unique_lock lock(subscribers_mutex_);
-				std::erase_if(subscribers_, [](const Subscriber& s) { return !s.active; });
+				// compaction: drop tombstones, then point the surviving slots at their new positions
+				if (std::erase_if(subscribers_, [](const Subscriber& s) { return !s.active; }) != 0)
+					reindex_subscribers();
+
+				for (EventEntity entity : dirty_entities_)
+				{
+					auto* subs = entity_subscribers_.try_get(entity);
+					if (!subs) continue;
+					std::erase_if(*subs, [](const Subscriber& s) { return !s.active; });
+					for (uint32_t i = 0; i < subs->size(); ++i)
+						slots_[(*subs)[i].slot].index = i;
+					if (subs->empty()) entity_subscribers_.erase(entity);
+				}
+				dirty_entities_.clear();
+
+				free_slots_.insert(free_slots_.end(), released_slots_.begin(), released_slots_.end());
+				released_slots_.clear();
 			}
 		};
 	private:
-		std::array<std::unique_ptr<EventDataWrapper>, 1024> event_data_;
-		std::array<PublisherRecord, 65536> publishers_;
+		// registries are paged so an idle bus costs a few KB, not megabytes
+		details::PagedTable<std::atomic<EventDataWrapper*>, 64, 16> event_data_;
+		details::PagedTable<PublisherRecord, 256, 256> publishers_;
+		std::vector<std::unique_ptr<EventDataWrapper>> types_;	// owns event_data_ entries
+		// per-bus state only: independent buses may live on different threads
 		std::atomic<uint64_t> next_publisher_id_{ 1 };
-		static inline std::atomic<uint64_t> next_subscriber_id_{ 1 };
+		std::mutex creation_mutex_;
+
+		// types with pending events / with subscribers to erase; commit_batch visits only these
+		std::mutex dirty_mutex_;
+		std::vector<EventDataWrapper*> dirty_types_;
+		std::vector<EventDataWrapper*> cleanup_types_;
+		std::vector<EventDataWrapper*> committing_;
+		std::vector<EventDataWrapper*> parallel_;
+
+		std::atomic<EventRecorder*> recorder_{ nullptr };
+
+		std::atomic<bool> stats_enabled_{ false };
+		uint64_t batch_index_{ 0 };
 
 		template<typename Event_t>
 		EventData<Event_t>& get_typed_data() {
 			const uint64_t type_id = reflection::EventFamily::getID<Event_t>();
-			if (!event_data_[type_id]) {
-				static std::mutex creation_mutex;
-				std::lock_guard lock(creation_mutex);
-				if (!event_data_[type_id]) {
-					event_data_[type_id] = std::make_unique<EventData<Event_t>>();
+			if (type_id >= decltype(event_data_)::kCapacity)
+				throw std::runtime_error("EventBus2: too many event types");
+
+			auto& slot = event_data_.ensure(type_id);
+			EventDataWrapper* data = slot.load(std::memory_order_acquire);
+			if (!data) {
+				std::lock_guard lock(creation_mutex_);
+				data = slot.load(std::memory_order_relaxed);
+				if (!data) {
+					types_.push_back(std::make_unique<EventData<Event_t>>());
+					data = types_.back().get();
+					slot.store(data, std::memory_order_release);
 				}
 			}
-			return static_cast<EventData<Event_t>&>(*event_data_[type_id]);
+			return static_cast<EventData<Event_t>&>(*data);
+		}
+
+		// a null function pointer converts to an empty delegate, which cannot be called
+		static SubscriberToken reject_empty_callback() {
+			log::error("EventBus: cannot subscribe an empty callback.");
+			return SubscriberToken{};
+		}
+
+		template<typename Event_t>
+		static SubscriberToken make_subscriber_token(uint32_t slot, uint32_t generation) {
+			const uint64_t type_id = reflection::EventFamily::getID<Event_t>();
+			return SubscriberToken(type_id << 32 | slot, generation);
+		}
+
+		void mark_dirty(EventDataWrapper& data) {
+			if (data.queued_.load(std::memory_order_relaxed) || data.queued_.exchange(true)) return;
+			std::lock_guard lock(dirty_mutex_);
+			dirty_types_.push_back(&data);
 		}
 
 	public:
@@ -196,7 +730,9 @@ namespace csyren::core::events
 			const uint64_t pub_id = token._data;
 			if (pub_id == 0 || pub_id >= next_publisher_id_.load()) return;
 
-			auto& pub_record = publishers_[pub_id];
+			auto* found = publishers_.find(pub_id);
+			if (!found) return;
+			auto& pub_record = *found;
 
 			//invalidate record;
 			pub_record.generation = pub_record.generation >= MAX_GENERATION ? 0 : pub_record.generation + 1;
@@ -204,29 +740,78 @@ namespace csyren::core::events
 			pub_record.type_id = 0;
 		}
 
+		/**
+		 * @brief Subscribes to every `Event_t`; higher `priority` is called earlier.
+		 *
+		 * Subscribing from inside an `Event_t` callback is allowed: the new
+		 * subscriber is added once that dispatch returns and sees the next event.
+		 */
 		template<class Event_t>
-		SubscriberToken subscribe(Callback_t<Event_t>&& callback) {
+		SubscriberToken subscribe(Callback_t<Event_t>&& callback, int priority = 0) {
 			using Clean_t = std::decay_t<Event_t>;
-			auto& data = get_typed_data<Clean_t>();
-			const uint64_t sub_id = data.subscribe(std::move(callback), std::nullopt);
-			return SubscriberToken(sub_id);
+			if (!callback) return reject_empty_callback();
+			auto [slot, generation] = get_typed_data<Clean_t>().subscribe(std::move(callback), std::nullopt, priority);
+			return make_subscriber_token<Clean_t>(slot, generation);
 		}
 
 		template<class Event_t>
-		SubscriberToken subscribe(EventMarker mark, Callback_t<Event_t>&& callback) {
-			auto& data = get_typed_data<Event_t>();
-			const uint64_t sub_id = data.subscribe(std::move(callback), mark);
-			return SubscriberToken(sub_id);
+		SubscriberToken subscribe(EventMarker mark, Callback_t<Event_t>&& callback, int priority = 0) {
+			using Clean_t = std::decay_t<Event_t>;
+			if (!callback) return reject_empty_callback();
+			auto [slot, generation] = get_typed_data<Clean_t>().subscribe(std::move(callback), mark, priority);
+			return make_subscriber_token<Clean_t>(slot, generation);
+		}
+
+		/**
+		 * @brief Chooses how `Event_t` is delivered from now on.
+		 *
+		 * Immediate types skip the queue: publish() runs the subscribers inline, in
+		 * priority order, on the caller's reference, so input can become an action
+		 * in the same frame. Like commit_batch, publish such types only from the
+		 * thread that owns their subscribers. Already queued events still go out
+		 * with the next commit_batch.
+		 */
+		template<class Event_t>
+		void set_delivery(Delivery mode) {
+			get_typed_data<std::decay_t<Event_t>>().immediate_.store(mode == Delivery::Immediate, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Subscribes to `Event_t` instances about one entity only.
+		 *
+		 * Delivery costs one sparse lookup per event instead of a callback per
+		 * subscriber, so thousands of per-entity listeners stay cheap. See event_entity.
+		 * As with subscribe(), subscribing from a callback takes effect from the next event.
+		 */
+		template<class Event_t>
+		SubscriberToken subscribe_entity(EventEntity entity, Callback_t<Event_t>&& callback) {
+			if (!callback) return reject_empty_callback();
+			using Clean_t = std::decay_t<Event_t>;
+			static_assert(has_event_entity_v<Clean_t>, "EventBus2::subscribe_entity: event has no entity, specialize event_entity");
+			auto [slot, generation] = get_typed_data<Clean_t>().subscribe_entity(entity, std::move(callback), std::nullopt);
+			return make_subscriber_token<Clean_t>(slot, generation);
+		}
+
+		template<class Event_t>
+		SubscriberToken subscribe_entity(EventEntity entity, EventMarker mark, Callback_t<Event_t>&& callback) {
+			if (!callback) return reject_empty_callback();
+			using Clean_t = std::decay_t<Event_t>;
+			static_assert(has_event_entity_v<Clean_t>, "EventBus2::subscribe_entity: event has no entity, specialize event_entity");
+			auto [slot, generation] = get_typed_data<Clean_t>().subscribe_entity(entity, std::move(callback), mark);
+			return make_subscriber_token<Clean_t>(slot, generation);
 		}
 
 		void unsubscribe(SubscriberToken token) {
 			if (!token.valid()) return;
-			// This part is inefficient as it iterates all event types.
-			// A better design would map token to event type. For now, it works.
-			for (auto& data_ptr : event_data_) {
-				if (data_ptr) {
-					data_ptr->unsubscribe(token._data);
-				}
+			// the token names its type and slot: tombstone it there, compact in commit_batch
+			auto* slot = event_data_.find(token._data >> 32);
+			EventDataWrapper* data = slot ? slot->load(std::memory_order_acquire) : nullptr;
+			if (!data || !data->unsubscribe(static_cast<uint32_t>(token._data), token._generation)) return;
+
+			std::lock_guard lock(dirty_mutex_);
+			if (!data->needs_cleanup_) {
+				data->needs_cleanup_ = true;
+				cleanup_types_.push_back(data);
 			}
 		}
 
@@ -240,50 +825,312 @@ namespace csyren::core::events
 			publish_impl(token, std::move(event));
 		}
 
-		void commit_batch() 
-		{
-			//1.dispatch all pending events
-			for (auto& data_ptr : event_data_) {
-				if (data_ptr) {
-					data_ptr->commit();
+		/// @brief Publishes a batch of events with one token check and one queue lock.
+		template<typename Event_t>
+		void publish(PublishToken token, std::span<Event_t> events) {
+			using Clean_t = std::remove_cv_t<Event_t>;
+			const PublisherRecord* pub_record = find_publisher<Clean_t>(token);
+			if (!pub_record) return;
+
+			auto& data = get_typed_data<Clean_t>();
+			if (stats_enabled_.load(std::memory_order_relaxed))
+				data.counters_.published.fetch_add(events.size(), std::memory_order_relaxed);
+			if (data.immediate_.load(std::memory_order_relaxed)) {
+				if (EventRecorder* recorder = recorder_.load(std::memory_order_acquire)) {
+					for (const auto& event : events)
+						recorder->record(event, pub_record->marker, in_dispatch());
+				}
+				const auto timer = start_timer(stats_enabled_.load(std::memory_order_relaxed));
+				DispatchScope scope(this);
+				size_t delivered = 0;
+				for (auto& event : events) {
+					if constexpr (std::is_const_v<Event_t>) {
+						Clean_t copy(event);	// subscribers take a mutable reference
+						delivered += data.dispatch(copy, pub_record->marker);
+					}
+					else {
+						delivered += data.dispatch(event, pub_record->marker);
+					}
 				}
+				count_immediate(data, timer, delivered);
+				return;
 			}
+			data.publish(std::span<const Clean_t>(events), pub_record->marker, in_dispatch());
+			mark_dirty(data);
+		}
+
+		/**
+		 * @brief Starts (or with nullptr stops) copying every delivered event and commit to `recorder`.
+		 *
+		 * Batched events are recorded as commit_batch() delivers them, so the stream
+		 * follows delivery order; immediate events are recorded when published.
+		 * Events published from a callback of this bus are flagged nested: replaying
+		 * the batch that caused them makes the subscribers publish them again.
+		 * The recorder must outlive the recording; replay it with EventReplayer.
+		 */
+		void set_recorder(EventRecorder* recorder) noexcept {
+			recorder_.store(recorder, std::memory_order_release);
+		}
+
+		/**
+		 * @brief Turns the per-type counters on or off (off by default).
+		 *
+		 * While on, every publish bumps an atomic and every commit reads the clock
+		 * per dispatched type. Read the counters between frames, from the thread
+		 * that calls commit_batch.
+		 */
+		void set_stats_enabled(bool enabled) noexcept {
+			stats_enabled_.store(enabled, std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] bool stats_enabled() const noexcept {
+			return stats_enabled_.load(std::memory_order_relaxed);
+		}
+
+		template<class Event_t>
+		[[nodiscard]] EventTypeStats stats_of() {
+			return make_stats(get_typed_data<std::decay_t<Event_t>>(), batch_index_);
+		}
 
-			for (auto& data_ptr : event_data_) 
+		/// @brief Counters of every event type the bus has seen, heaviest callback time first.
+		[[nodiscard]] std::vector<EventTypeStats> stats() {
+			std::vector<EventTypeStats> result;
 			{
-				if (data_ptr) {
-					data_ptr->cleanup_subscribers();
-				}
+				std::lock_guard lock(creation_mutex_);
+				result.reserve(types_.size());
+				for (const auto& data : types_)
+					result.push_back(make_stats(*data, batch_index_));
+			}
+			std::sort(result.begin(), result.end(), [](const EventTypeStats& a, const EventTypeStats& b)
+				{ return a.callback_ms_total > b.callback_ms_total; });
+			return result;
+		}
+
+		/// @brief Writes stats() as CSV, one line per event type.
+		void dump_stats(std::ostream& out) {
+			out << "type,id,published_last_batch,delivered_last_batch,callback_ms_last_batch,"
+				"published_total,delivered_total,callback_ms_total,peak_pending\n";
+			for (const auto& s : stats()) {
+				out << '"' << s.name << "\"," << s.type_id << ',' << s.published_last_batch << ','
+					<< s.delivered_last_batch << ',' << s.callback_ms_last_batch << ','
+					<< s.published_total << ',' << s.delivered_total << ',' << s.callback_ms_total << ','
+					<< s.peak_pending << '\n';
 			}
 		}
 
+		bool dump_stats(const std::string& path) {
+			std::ofstream file(path);
+			if (!file) {
+				log::error("EventBus: cannot open stats file {}", path);
+				return false;
+			}
+			dump_stats(file);
+			return static_cast<bool>(file);
+		}
+
+		/**
+		 * @brief Marks `Event_t` as safe to dispatch on a worker thread, concurrently with other such types.
+		 *
+		 * Its subscribers must not touch state shared with other types' subscribers
+		 * and must not subscribe or unsubscribe during dispatch. Only affects
+		 * commit_batch(cstdmf::JobSystem&).
+		 */
+		template<class Event_t>
+		void set_thread_safe(bool thread_safe = true) {
+			get_typed_data<std::decay_t<Event_t>>().thread_safe_.store(thread_safe, std::memory_order_relaxed);
+		}
+
+		void commit_batch() 
+		{
+			commit_batch_impl(nullptr);
+		}
+
+		/**
+		 * @brief commit_batch() that dispatches thread-safe types in parallel on `jobs`.
+		 *
+		 * Each thread-safe type is one job, so its subscribers still see its events
+		 * in the same order as with commit_batch(); only the interleaving between
+		 * types changes. The remaining types are dispatched afterwards on the
+		 * calling thread, as usual. Called from inside a job of `jobs` (e.g. a
+		 * WorldHost tick), every type is dispatched on the calling thread instead.
+		 */
+		void commit_batch(cstdmf::JobSystem& jobs)
+		{
+			commit_batch_impl(&jobs);
+		}
+
 	private:
+		using StatsClock = std::chrono::steady_clock;
+
+		// callback time charged to the types timed further up this thread's stack
+		static inline thread_local uint64_t nested_ns_{ 0 };
+
+		// the clock is read only while stats are on
+		struct CallbackTimer {
+			StatsClock::time_point start{};
+			uint64_t outer_nested_ns{ 0 };
+		};
+
+		static CallbackTimer start_timer(bool stats) {
+			if (!stats) return {};
+			return { StatsClock::now(), std::exchange(nested_ns_, 0) };
+		}
+
+		// exclusive time: an immediate publish from a callback is charged to its own type, not also to the outer one
+		static void stop_timer(EventDataWrapper& data, const CallbackTimer& timer) {
+			const uint64_t total = elapsed_ns(timer.start);
+			data.counters_.callback_ns += total - std::min(nested_ns_, total);
+			nested_ns_ = timer.outer_nested_ns + total;
+		}
+
+		static uint64_t elapsed_ns(StatsClock::time_point start) {
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(StatsClock::now() - start).count());
+		}
+
+		// immediate types have no queue: time the inline dispatch and let the next commit close their batch
+		void count_immediate(EventDataWrapper& data, const CallbackTimer& timer, size_t delivered) {
+			if (timer.start == StatsClock::time_point{}) return;
+			data.counters_.delivered += delivered;
+			stop_timer(data, timer);
+			mark_dirty(data);
+		}
+
+		void commit_type(EventDataWrapper& data, bool stats) {
+			DispatchScope scope(this);
+			EventRecorder* recorder = recorder_.load(std::memory_order_acquire);
+			if (!stats) {
+				data.commit(recorder, false);
+				return;
+			}
+			const auto timer = start_timer(true);
+			const uint64_t drained = data.commit(recorder, true);
+			stop_timer(data, timer);
+			auto& counters = data.counters_;
+			counters.peak_pending = std::max(counters.peak_pending, drained);
+			counters.close_batch(batch_index_);
+		}
+
+		static EventTypeStats make_stats(const EventDataWrapper& data, uint64_t batch) {
+			const auto& counters = data.counters_;
+			EventTypeStats stats;
+			stats.name = data.name_;
+			stats.type_id = data.type_id_;
+			if (counters.batch == batch && batch != 0) {
+				stats.published_last_batch = counters.last_published;
+				stats.delivered_last_batch = counters.last_delivered;
+				stats.callback_ms_last_batch = counters.last_callback_ns / 1e6;
+			}
+			stats.published_total = counters.published.load(std::memory_order_relaxed);
+			stats.delivered_total = counters.delivered;
+			stats.callback_ms_total = counters.callback_ns / 1e6;
+			stats.peak_pending = counters.peak_pending;
+			return stats;
+		}
+
+		void commit_batch_impl(cstdmf::JobSystem* jobs)
+		{
+			const bool stats = stats_enabled_.load(std::memory_order_relaxed);
+			++batch_index_;
+
+			//1.dispatch pending events of the types published since the last batch
+			{
+				std::lock_guard lock(dirty_mutex_);
+				committing_.swap(dirty_types_);
+			}
+			// cleared first: events published from callbacks queue the type for the next batch
+			for (EventDataWrapper* data : committing_)
+				data->queued_.store(false);
+
+			if (jobs) {
+				auto sequential = std::stable_partition(committing_.begin(), committing_.end(),
+					[](const EventDataWrapper* data) { return data->thread_safe_.load(std::memory_order_relaxed); });
+				parallel_.assign(committing_.begin(), sequential);
+				committing_.erase(committing_.begin(), sequential);
+				jobs->parallelFor(parallel_.size(), [this, stats](size_t i) { commit_type(*parallel_[i], stats); });
+				parallel_.clear();
+			}
+			for (EventDataWrapper* data : committing_) {
+				commit_type(*data, stats);
+			}
+			committing_.clear();
+			// after the drained events, so replay publishes them before committing
+			if (EventRecorder* recorder = recorder_.load(std::memory_order_acquire))
+				recorder->record_commit();
+
+			//2.erase unsubscribed entries of the types that had any
+			{
+				std::lock_guard lock(dirty_mutex_);
+				committing_.swap(cleanup_types_);
+				for (EventDataWrapper* data : committing_)
+					data->needs_cleanup_ = false;
+			}
+			for (EventDataWrapper* data : committing_) {
+				data->cleanup_subscribers();
+			}
+			committing_.clear();
+		}
+
+		// the bus whose callbacks run on this thread: events they publish are nested
+		static inline thread_local const EventBus2* dispatching_{ nullptr };
+
+		struct DispatchScope {
+			explicit DispatchScope(const EventBus2* bus) noexcept : previous_(std::exchange(dispatching_, bus)) {}
+			~DispatchScope() { dispatching_ = previous_; }
+			DispatchScope(const DispatchScope&) = delete;
+			DispatchScope& operator=(const DispatchScope&) = delete;
+			const EventBus2* previous_;
+		};
+
+		bool in_dispatch() const noexcept { return dispatching_ == this; }
+
+		/// @brief The publisher record behind `token` if it is live and publishes `Event_t`.
 		template<typename Event_t>
-		void publish_impl(PublishToken token, Event_t&& event) {
-			if (!token.valid()) return;
+		const PublisherRecord* find_publisher(PublishToken token) {
+			if (!token.valid()) return nullptr;
 
-			using Clean_t = std::decay_t<Event_t>;
 			const uint64_t pub_id = token._data;
-			if (pub_id == 0 || pub_id >= next_publisher_id_.load()) return;
+			if (pub_id == 0 || pub_id >= next_publisher_id_.load()) return nullptr;
 
-			const auto& pub_record = publishers_[pub_id];
-			const uint64_t type_id = reflection::EventFamily::getID<Clean_t>();
+			const auto* pub_record = publishers_.find(pub_id);
+			if (!pub_record) return nullptr;
+			const uint64_t type_id = reflection::EventFamily::getID<Event_t>();
+
+			if (pub_record->type_id != type_id) return nullptr;
+			if (pub_record->generation != token._generation) return nullptr;
+			return pub_record;
+		}
 
-			if (pub_record.type_id != type_id) return;
-			if (pub_record.generation != token._generation) return;
+		template<typename Event_t>
+		void publish_impl(PublishToken token, Event_t&& event) {
+			using Clean_t = std::decay_t<Event_t>;
+			const PublisherRecord* pub_record = find_publisher<Clean_t>(token);
+			if (!pub_record) return;
 
-			get_typed_data<Clean_t>().publish(&event, pub_record.marker);
+			auto& data = get_typed_data<Clean_t>();
+			if (stats_enabled_.load(std::memory_order_relaxed))
+				data.counters_.published.fetch_add(1, std::memory_order_relaxed);
+			if (data.immediate_.load(std::memory_order_relaxed)) {
+				if (EventRecorder* recorder = recorder_.load(std::memory_order_acquire))
+					recorder->record(static_cast<const Clean_t&>(event), pub_record->marker, in_dispatch());
+				const auto timer = start_timer(stats_enabled_.load(std::memory_order_relaxed));
+				DispatchScope scope(this);
+				const size_t delivered = data.dispatch(static_cast<Clean_t&>(event), pub_record->marker);
+				count_immediate(data, timer, delivered);
+				return;
+			}
+			data.publish(std::forward<Event_t>(event), pub_record->marker, in_dispatch());
+			mark_dirty(data);
 		}
 		template<typename Event_t>
 		PublishToken register_publisher_impl(std::optional<EventMarker> marker) {
 			const uint64_t pub_id = next_publisher_id_.fetch_add(1);
 			using Clean_t = std::decay_t<Event_t>;
-			if (pub_id >= publishers_.size())
+			if (pub_id >= publishers_.kCapacity)
 			{
 				log::error("EventBus: too many publishers been created.");
 				return PublishToken(INVALID_TOKEN);
 			}
-			publishers_[pub_id] = { reflection::EventFamily::getID<Clean_t>(), marker };
+			publishers_.ensure(pub_id) = { reflection::EventFamily::getID<Clean_t>(), marker };
 			return PublishToken(pub_id);
 		}
 	private:
@@ -0,0 +1,12 @@
+#ifndef __CSYREN_EVENT_MARKER__
+#define __CSYREN_EVENT_MARKER__
+
+#include <cstdint>
+
+namespace csyren::core::events
+{
+	/// @brief Channel tag of a publisher; marked subscribers only see events carrying their marker.
+	using EventMarker = uint32_t;
+}
+
+#endif
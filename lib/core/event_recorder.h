@@ -0,0 +1,121 @@
+#ifndef __CSYREN_EVENT_RECORDER__
+#define __CSYREN_EVENT_RECORDER__
+
+#include "event_marker.h"
+#include "family_generator.h"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <type_traits>
+
+namespace csyren::core::events
+{
+	/**
+	 * @brief Stream layout shared by EventRecorder and EventReplayer.
+	 *
+	 * Native endianness; meant to be read back by the same build.
+	 *   header:        u32 magic, u32 version
+	 *   event record:  u8 RecordKind::Event, u64 type hash, u8 EventFlags, u32 marker,
+	 *                  u64 time, u32 payload size, payload bytes
+	 *   commit record: u8 RecordKind::Commit, u64 time
+	 * Times are nanoseconds since the recorder was created. Events that are not
+	 * trivially copyable are recorded with an empty payload and cannot be replayed.
+	 */
+	namespace stream_format
+	{
+		constexpr uint32_t kMagic = 0x56455343;	// "CSEV"
+		constexpr uint32_t kVersion = 2;
+
+		enum class RecordKind : uint8_t { Event = 0, Commit = 1 };
+
+		enum EventFlags : uint8_t
+		{
+			Marked = 1 << 0,	// the marker field is meaningful
+			Nested = 1 << 1,	// published by a subscriber while the bus was dispatching
+		};
+	}
+
+	/**
+	 * @brief Writes every event delivered by a bus, plus its commit points, to a binary stream.
+	 *
+	 * Attach with EventBus2::set_recorder. Events are written in delivery order;
+	 * the threads delivering them share one lock while recording, so keep it for
+	 * repro and benchmark captures.
+	 */
+	class EventRecorder
+	{
+	public:
+		explicit EventRecorder(std::ostream& out)
+			: out_(out), start_(std::chrono::steady_clock::now())
+		{
+			write(stream_format::kMagic);
+			write(stream_format::kVersion);
+		}
+
+		EventRecorder(const EventRecorder&) = delete;
+		EventRecorder& operator=(const EventRecorder&) = delete;
+
+		template<typename Event_t>
+		void record(const Event_t& event, const std::optional<EventMarker>& marker, bool nested = false)
+		{
+			constexpr uint64_t type_hash = reflection::typeHash<Event_t>();
+			constexpr uint32_t size = std::is_trivially_copyable_v<Event_t> ? sizeof(Event_t) : 0;
+
+			std::lock_guard lock(mutex_);
+			write(stream_format::RecordKind::Event);
+			write(type_hash);
+			write(static_cast<uint8_t>((marker ? stream_format::Marked : 0) | (nested ? stream_format::Nested : 0)));
+			write(marker.value_or(0));
+			write(now());
+			write(size);
+			if constexpr (size != 0)
+				out_.write(reinterpret_cast<const char*>(&event), size);
+			++events_;
+		}
+
+		/// @brief Marks a commit_batch: replay delivers everything recorded before it as one batch.
+		void record_commit()
+		{
+			std::lock_guard lock(mutex_);
+			write(stream_format::RecordKind::Commit);
+			write(now());
+			++commits_;
+		}
+
+		[[nodiscard]] size_t event_count() const
+		{
+			std::lock_guard lock(mutex_);
+			return events_;
+		}
+
+		[[nodiscard]] size_t commit_count() const
+		{
+			std::lock_guard lock(mutex_);
+			return commits_;
+		}
+
+	private:
+		template<typename T>
+		void write(const T& value)
+		{
+			out_.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		uint64_t now() const
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - start_).count());
+		}
+
+		std::ostream& out_;
+		const std::chrono::steady_clock::time_point start_;
+		mutable std::mutex mutex_;
+		size_t events_{ 0 };
+		size_t commits_{ 0 };
+	};
+}
+
+#endif
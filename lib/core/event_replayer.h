@@ -0,0 +1,187 @@
+#ifndef __CSYREN_EVENT_REPLAYER__
+#define __CSYREN_EVENT_REPLAYER__
+
+#include "event_bus.h"
+#include "event_recorder.h"
+
+#include <cstring>
+#include <istream>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace csyren::core::events
+{
+	/**
+	 * @brief Feeds a stream written by EventRecorder back into a bus, batch by batch.
+	 *
+	 * Every event type to replay is registered with add<T>(); records of other
+	 * types, events recorded without payload and nested events (published by
+	 * subscribers, which publish them again during replay) are skipped and
+	 * counted. Each replayed batch ends with the bus' commit_batch(), exactly
+	 * where the recording committed, so subscribers see the same batches with
+	 * the same events in the same order.
+	 * @code
+	 * EventReplayer replay(file);
+	 * replay.add<KeyEvent>();
+	 * while (replay.replay_batch(bus)) scene.flush();
+	 * @endcode
+	 */
+	class EventReplayer
+	{
+	public:
+		explicit EventReplayer(std::istream& in) : in_(in)
+		{
+			uint32_t magic = 0, version = 0;
+			if (!read(magic) || magic != stream_format::kMagic)
+				throw std::runtime_error("EventReplayer: not an event stream");
+			if (!read(version) || version != stream_format::kVersion)
+				throw std::runtime_error("EventReplayer: unsupported event stream version");
+		}
+
+		EventReplayer(const EventReplayer&) = delete;
+		EventReplayer& operator=(const EventReplayer&) = delete;
+
+		template<typename Event_t>
+		void add()
+		{
+			static_assert(std::is_trivially_copyable_v<Event_t>, "EventReplayer: only trivially copyable events are recorded with payload");
+			types_[reflection::typeHash<Event_t>()] = Handler{
+				sizeof(Event_t),
+				[](EventBus2& bus, const std::optional<EventMarker>& marker)
+				{
+					return marker ? bus.register_publisher<Event_t>(*marker) : bus.register_publisher<Event_t>();
+				},
+				[](EventBus2& bus, PublishToken token, const std::byte* payload)
+				{
+					alignas(Event_t) std::byte storage[sizeof(Event_t)];
+					std::memcpy(storage, payload, sizeof(Event_t));
+					bus.publish(token, *std::launder(reinterpret_cast<Event_t*>(storage)));
+				} };
+		}
+
+		/**
+		 * @brief Publishes the next recorded batch into `bus` and commits it.
+		 *
+		 * Returns false once the stream is exhausted; events after the last
+		 * recorded commit are published and committed as a final batch.
+		 */
+		bool replay_batch(EventBus2& bus)
+		{
+			if (&bus != bus_)
+			{
+				publishers_.clear();
+				bus_ = &bus;
+			}
+
+			bool any = false;
+			stream_format::RecordKind kind;
+			while (read(kind))
+			{
+				any = true;
+				if (kind == stream_format::RecordKind::Commit)
+				{
+					read_or_throw(batch_time_);
+					bus.commit_batch();
+					++batches_;
+					return true;
+				}
+				if (kind != stream_format::RecordKind::Event)
+					throw std::runtime_error("EventReplayer: corrupt event stream");
+				replay_event(bus);
+			}
+			if (any)
+			{
+				bus.commit_batch();
+				++batches_;
+			}
+			return any;
+		}
+
+		/// @brief Replays the rest of the stream; returns the number of batches.
+		size_t replay(EventBus2& bus)
+		{
+			const size_t before = batches_;
+			while (replay_batch(bus)) {}
+			return batches_ - before;
+		}
+
+		[[nodiscard]] size_t replayed() const noexcept { return replayed_; }
+		[[nodiscard]] size_t skipped() const noexcept { return skipped_; }
+		/// @brief Recording time (ns since recording started) of the last replayed commit.
+		[[nodiscard]] uint64_t batch_time() const noexcept { return batch_time_; }
+
+	private:
+		struct Handler
+		{
+			uint32_t size;
+			PublishToken(*register_publisher)(EventBus2&, const std::optional<EventMarker>&);
+			void(*publish)(EventBus2&, PublishToken, const std::byte*);
+		};
+
+		void replay_event(EventBus2& bus)
+		{
+			uint64_t type_hash = 0, time = 0;
+			uint8_t flags = 0;
+			EventMarker marker = 0;
+			uint32_t size = 0;
+			read_or_throw(type_hash);
+			read_or_throw(flags);
+			read_or_throw(marker);
+			read_or_throw(time);
+			read_or_throw(size);
+
+			payload_.resize(size);
+			if (size != 0 && !in_.read(reinterpret_cast<char*>(payload_.data()), size))
+				throw std::runtime_error("EventReplayer: truncated event stream");
+
+			auto handler = types_.find(type_hash);
+			if (handler == types_.end() || size == 0 || (flags & stream_format::Nested))
+			{
+				++skipped_;
+				return;
+			}
+			if (handler->second.size != size)
+				throw std::runtime_error("EventReplayer: event size differs from the recording build");
+
+			const bool marked = flags & stream_format::Marked;
+			const std::optional<EventMarker> publisher_marker = marked ? std::optional<EventMarker>(marker) : std::nullopt;
+			auto key = std::make_tuple(type_hash, marked, marker);
+			auto publisher = publishers_.find(key);
+			if (publisher == publishers_.end())
+				publisher = publishers_.emplace(key, handler->second.register_publisher(bus, publisher_marker)).first;
+
+			handler->second.publish(bus, publisher->second, payload_.data());
+			++replayed_;
+		}
+
+		template<typename T>
+		bool read(T& value)
+		{
+			return static_cast<bool>(in_.read(reinterpret_cast<char*>(&value), sizeof(T)));
+		}
+
+		template<typename T>
+		void read_or_throw(T& value)
+		{
+			if (!read(value))
+				throw std::runtime_error("EventReplayer: truncated event stream");
+		}
+
+		std::istream& in_;
+		std::unordered_map<uint64_t, Handler> types_;
+		std::map<std::tuple<uint64_t, bool, EventMarker>, PublishToken> publishers_;	// for bus_
+		EventBus2* bus_{ nullptr };
+		std::vector<std::byte> payload_;
+		size_t replayed_{ 0 };
+		size_t skipped_{ 0 };
+		size_t batches_{ 0 };
+		uint64_t batch_time_{ 0 };
+	};
+}
+
+#endif
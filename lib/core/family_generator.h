@@ -1,5 +1,7 @@
 #pragma once
 #include <atomic>
+#include <cstdint>
+#include <string_view>
 
 namespace csyren::core::reflection
 {
@@ -20,4 +22,27 @@ namespace csyren::core::reflection
 			return s_nextID++;
 		}
 	};
+
+	/**
+	 * @brief 64-bit FNV-1a hash of the compiler's name for T.
+	 *
+	 * Unlike Family IDs it does not depend on registration order, so it identifies
+	 * a type across runs of the same build (e.g. in recorded streams).
+	 */
+	template<class T>
+	constexpr uint64_t typeHash() noexcept
+	{
+#if defined(_MSC_VER)
+		const std::string_view name = __FUNCSIG__;
+#else
+		const std::string_view name = __PRETTY_FUNCTION__;
+#endif
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (const char c : name)
+		{
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
 }
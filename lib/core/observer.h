@@ -0,0 +1,128 @@
+#ifndef __CSYREN_OBSERVER__
+#define __CSYREN_OBSERVER__
+
+#include "entity.h"
+#include "component_base.h"
+
+#include "cstdmf/sparse_set.h"
+
+#include <bitset>
+#include <cstdint>
+
+namespace csyren::core
+{
+	enum class ObserveOn : uint8_t
+	{
+		Added = 1 << 0,
+		Removed = 1 << 1,
+		Changed = 1 << 2,
+	};
+
+	constexpr ObserveOn operator|(ObserveOn a, ObserveOn b) noexcept
+	{
+		return static_cast<ObserveOn>(static_cast<uint8_t>(a) | static_cast<uint8_t>(b));
+	}
+
+	constexpr bool hasFlag(ObserveOn set, ObserveOn flag) noexcept
+	{
+		return (static_cast<uint8_t>(set) & static_cast<uint8_t>(flag)) != 0;
+	}
+
+	/**
+	 * @brief Collects entities whose trigger component was added, removed or changed.
+	 *
+	 * Created by Scene::observe. The scene inserts entities directly (no events, no
+	 * callbacks); a system drains the set once per frame with each() + clear().
+	 * The filter is evaluated at drain time, so the order in which an entity received
+	 * its components during the frame does not matter.
+	 */
+	class Observer
+	{
+		friend class Scene;
+		using Mask = std::bitset<reflection::MAX_COMPONENT_TYPES>;
+	public:
+		Observer(const cstdmf::SparseSet<Entity>& entities, size_t family, ObserveOn events, Mask with, Mask without) noexcept
+			: _sceneEntities(&entities), _family(family), _events(events), _with(with), _without(without) {}
+
+		Observer(const Observer&) = delete;
+		Observer& operator=(const Observer&) = delete;
+
+		/**
+		 * @brief Calls `fn(Entity::ID)` for every collected entity that passes the filter.
+		 *
+		 * Entities destroyed since they were collected are reported only by observers
+		 * that listen for ObserveOn::Removed, without the filter. If the ID already
+		 * names a new entity that triggered too, the ID is reported twice: once for
+		 * the destroyed entity, once (filtered) for the new one.
+		 */
+		template<typename Fn>
+		void each(Fn&& fn) const
+		{
+			auto state = _collected.begin();
+			for (auto it = _collected.key_begin(); it != _collected.key_end(); ++it, ++state)
+			{
+				if (*state & kStale) fn(*it);
+				if (!(*state & kLive)) continue;
+
+				const Entity* ent = _sceneEntities->try_get(*it);
+				if (!ent)
+				{
+					if (hasFlag(_events, ObserveOn::Removed)) fn(*it);
+					continue;
+				}
+				if ((ent->components & _with) == _with && (ent->components & _without).none())
+					fn(*it);
+			}
+		}
+
+		/// @brief each() followed by clear().
+		template<typename Fn>
+		void drain(Fn&& fn)
+		{
+			each(std::forward<Fn>(fn));
+			clear();
+		}
+
+		[[nodiscard]] bool contains(Entity::ID id) const noexcept { return _collected.contains(id); }
+		[[nodiscard]] size_t size() const noexcept { return _collected.size(); }
+		[[nodiscard]] bool empty() const noexcept { return _collected.empty(); }
+
+		void clear() noexcept { _collected.clear(); }
+
+		[[nodiscard]] size_t family() const noexcept { return _family; }
+		[[nodiscard]] ObserveOn events() const noexcept { return _events; }
+
+	private:
+		static constexpr uint8_t kLive = 1 << 0;	// the entity currently holding the ID triggered
+		static constexpr uint8_t kStale = 1 << 1;	// a destroyed former holder of the ID is pending a Removed report
+
+		void notify(Entity::ID id, ObserveOn event)
+		{
+			if (!hasFlag(_events, event)) return;
+			if (uint8_t* state = _collected.try_get(id))
+				*state |= kLive;
+			else
+				_collected.emplace(id, kLive);
+		}
+
+		// `id` names a new entity now; what was collected belongs to the destroyed one
+		void recycle(Entity::ID id)
+		{
+			uint8_t* state = _collected.try_get(id);
+			if (!state) return;
+			if (hasFlag(_events, ObserveOn::Removed))
+				*state = kStale;
+			else
+				_collected.erase(id);
+		}
+
+		cstdmf::SparseSet<uint8_t, Entity::ID> _collected;	// -> kLive / kStale bits
+		const cstdmf::SparseSet<Entity>* _sceneEntities;
+		size_t _family;
+		ObserveOn _events;
+		Mask _with;
+		Mask _without;
+	};
+}
+
+#endif
@@ -1,10 +1,15 @@
 #ifndef __CSYREN_SCENE__
 #define __CSYREN_SCENE__
 
+#include <atomic>
 #include <limits>
 #include <vector>
 #include <unordered_map>
+#include <bitset>
 #include <memory>
+#include <mutex>
+#include <span>
+#include <tuple>
 
 #include "component_base.h"
 #include "component_pool.h"
@@ -14,6 +19,11 @@
 
 #include "command_buffer.h"
 #include "event_bus.h"
+#include "observer.h"
+#include "component_index.h"
+#include "shared_component.h"
+
+#include "cstdmf/dynamic_bitset.h"
 
 class SceneTest;
 
@@ -35,14 +45,104 @@ namespace csyren::core::events
 		Entity::ID   entity;
 		T* ptr;
 	};
+
+	template<>
+	struct event_entity<EntityCreateEvent>
+	{
+		static EventEntity get(const EntityCreateEvent& event) noexcept { return event.id; }
+	};
+	template<>
+	struct event_entity<EntityDestroyEvent>
+	{
+		static EventEntity get(const EntityDestroyEvent& event) noexcept { return event.id; }
+	};
 }
 
 namespace csyren::core
 {
+	/// View term: entities that have any of `Ts` are skipped.
+	template<typename... Ts>
+	struct exclude {};
+
+	/// View term: `Ts` are not required; the view yields `Ts*` (nullptr when absent).
+	template<typename... Ts>
+	struct optional {};
+
+	namespace detail
+	{
+		template<typename... Ts>
+		struct type_list {};
+
+		template<typename... Ls>
+		struct concat { using type = type_list<>; };
+		template<typename... As>
+		struct concat<type_list<As...>> { using type = type_list<As...>; };
+		template<typename... As, typename... Bs, typename... Rest>
+		struct concat<type_list<As...>, type_list<Bs...>, Rest...>
+		{
+			using type = typename concat<type_list<As..., Bs...>, Rest...>::type;
+		};
+
+		template<typename T>
+		struct view_term
+		{
+			using include_list = type_list<T>;
+			using exclude_list = type_list<>;
+			using optional_list = type_list<>;
+		};
+		template<typename... Ts>
+		struct view_term<exclude<Ts...>>
+		{
+			using include_list = type_list<>;
+			using exclude_list = type_list<Ts...>;
+			using optional_list = type_list<>;
+		};
+		template<typename... Ts>
+		struct view_term<optional<Ts...>>
+		{
+			using include_list = type_list<>;
+			using exclude_list = type_list<>;
+			using optional_list = type_list<Ts...>;
+		};
+
+		template<typename... Cs>
+		struct view_terms
+		{
+			using include_list = typename concat<typename view_term<Cs>::include_list...>::type;
+			using exclude_list = typename concat<typename view_term<Cs>::exclude_list...>::type;
+			using optional_list = typename concat<typename view_term<Cs>::optional_list...>::type;
+		};
+	}
+
 	template<typename... Cs>
 	class SceneView;
 
 	class Application;
+	class Scene;
+	class RuntimeQuery;
+
+	/**
+	 * @brief Self-contained scene with its own event bus, meant to be filled off the main thread.
+	 *
+	 * A worker builds entities and components into `scene()` and hands the world over
+	 * with Scene::enqueueMerge. Events published into the staging bus are never delivered.
+	 */
+	class StagingWorld
+	{
+	public:
+		StagingWorld();
+		~StagingWorld();
+
+		StagingWorld(const StagingWorld&) = delete;
+		StagingWorld& operator=(const StagingWorld&) = delete;
+
+		Scene& scene() noexcept { return *_scene; }
+		const Scene& scene() const noexcept { return *_scene; }
+
+	private:
+		events::EventBus2		_bus;
+		std::unique_ptr<Scene>	_scene;
+	};
 
 
 	class Scene
@@ -50,14 +150,19 @@ namespace csyren::core
 		friend class Application;
 		friend SceneTest;
 		template<typename...> friend class SceneView;
+		friend class RuntimeQuery;
 
 		using DestructFn = bool(Scene*,const DestroyComponentCommand&,events::PublishToken,events::EventBus2&);
+		using MergeFn = void(Scene*, PoolBase&, const std::vector<Entity::ID>&);
 		struct ComponentMeta
 		{
 			std::shared_ptr<PoolBase> pool;
 			events::PublishToken      addToken;
 			events::PublishToken      removeToken;
 			DestructFn* removeFn = nullptr;
+			MergeFn*    mergeFn = nullptr;
+			std::vector<Observer*> observers;
+			std::vector<IndexBase*> indexes;
 		};
 		using ComponentsMeta = std::unordered_map<size_t, ComponentMeta>;
 
@@ -71,6 +176,7 @@ namespace csyren::core
 				T* ptr = pool ? pool->try_get(c.entt) : nullptr;
 				if (ptr)
 				{
+					self->notifyComponentEvent(c.family, c.entt, ObserveOn::Removed);
 					bus.publish(token, events::ComponentDestroyEvent<T>{c.entt, ptr});
 					pool->erase(c.entt);
 					if (Entity* ent = self->_entities.try_get(c.entt))
@@ -80,6 +186,62 @@ namespace csyren::core
 				}
 				return false;
 			}
+
+			static void emplaceThunk(Scene* self, EmplaceComponentCommand& c)
+			{
+				Entity* ent = self->_entities.try_get(c.entt);
+				if (!ent) return;
+
+				auto& value = *static_cast<typename component_payload<T>::type*>(c.payload);
+				if (ent->components.test(c.family))
+				{
+					if (!c.replace)
+					{
+						log::error("Scene::flush: deferred addComponent on entity that already has it.");
+						return;
+					}
+					if constexpr (is_shared_component_v<T>)
+					{
+						if (self->getPool<T>()->assign(c.entt, std::move(value)))
+							self->notifyComponentEvent(c.family, c.entt, ObserveOn::Changed);
+					}
+					else if (T* ptr = self->getPool<T>()->try_get(c.entt))
+					{
+						*ptr = std::move(value);
+						self->notifyComponentEvent(c.family, c.entt, ObserveOn::Changed);
+					}
+					return;
+				}
+
+				auto pool = self->getOrCreatePool<T>(c.family);
+				T* ptr = pool->emplace(c.entt, std::move(value));
+				if (self->_inactive.test(c.entt))
+					pool->deactivate(c.entt);
+				ent->components[c.family] = true;
+				self->notifyComponentEvent(c.family, c.entt, ObserveOn::Added);
+				self->_bus.publish(self->_meta[c.family].addToken, events::ComponentCreateEvent<T>{ c.entt, ptr });
+			}
+
+			static void mergeThunk(Scene* self, PoolBase& src, const std::vector<Entity::ID>& remap)
+			{
+				auto& from = static_cast<ComponentPool<T>&>(src);
+				const size_t family = reflection::ComponentFamily::getID<T>();
+				auto pool = self->getOrCreatePool<T>(family);
+
+				// appended entries are swapped into the active prefix, so remember keys up front
+				std::vector<Entity::ID> added;
+				added.reserve(from.size());
+				for (auto it = from.key_begin(); it != from.key_end(); ++it)
+					added.push_back(remap[*it]);
+				pool->append(std::move(from), [&remap](Entity::ID id) { return remap[id]; });
+
+				const events::PublishToken token = self->_meta[family].addToken;
+				for (const Entity::ID id : added)
+				{
+					self->notifyComponentEvent(family, id, ObserveOn::Added);
+					self->_bus.publish(token, events::ComponentCreateEvent<T>{ id, pool->try_get(id) });
+				}
+			}
 		};
 	public:
 		explicit Scene(events::EventBus2& bus) :_bus(bus)
@@ -90,33 +252,74 @@ namespace csyren::core
 
 		[[nodiscard]] Entity::ID createEntity(Entity::ID parent = Entity::invalidID)
 		{
-			Entity::ID id;
-			if (!_freeIDs.empty())
+			const Entity::ID id = allocateID();
+			materializeEntity(id);
+			setParent(id, parent);
+			return id;
+		}
+
+		/**
+		 * @brief Reserves an ID now and creates the entity on the next flush().
+		 *
+		 * The returned ID can be used right away with the other *Deferred calls.
+		 * Safe to call from worker threads while no flush() is running.
+		 */
+		[[nodiscard]] Entity::ID createEntityDeferred(Entity::ID parent = Entity::invalidID)
+		{
+			const Entity::ID id = allocateID();
+			_deferred.pushCreateEntity(id, parent);
+			return id;
+		}
+
+		/**
+		 * @brief Re-links `id` under `parent`. Passing `Entity::invalidID` detaches it.
+		 *
+		 * Parenting an entity under itself or one of its descendants is refused:
+		 * the hierarchy would become a cycle.
+		 */
+		void setParent(Entity::ID id, Entity::ID parent)
+		{
+			Entity* ent = _entities.try_get(id);
+			if (!ent) return;
+			if (isAncestorOrSelf(id, parent))
 			{
-				id = _freeIDs.back();
-				_freeIDs.pop_back();
+				log::error("Scene::setParent: entity {} cannot be parented under itself or its descendant {}", id, parent);
+				return;
 			}
-			else
+
+			if (ent->parent != Entity::invalidID)
 			{
-				if (_nextId == Entity::invalidID)
+				if (Entity* old = _entities.try_get(ent->parent))
 				{
-					throw std::runtime_error("Scene: out of Entity IDs");
+					auto& vec = old->childrens;
+					vec.erase(std::remove(vec.begin(), vec.end(), id), vec.end());
 				}
-				id = _nextId++;
 			}
-			_entities.emplace(id, Entity{});
-			Entity* ent = _entities.try_get(id);
-			ent->id = id;
-			ent->parent = parent;
-			if (parent != Entity::invalidID)
+
+			ent->parent = Entity::invalidID;
+			if (parent == Entity::invalidID) return;
+			if (Entity* p = _entities.try_get(parent))
 			{
-				if (Entity* p = _entities.try_get(parent))
-				{
-					p->childrens.push_back(id);
-				}
+				ent->parent = parent;
+				p->childrens.push_back(id);
 			}
-			_bus.publish(_entityCreateToken, events::EntityCreateEvent{id});
-			return id;
+		}
+
+		/// @brief True if `ancestor` is `id` or one of its parents.
+		bool isAncestorOrSelf(Entity::ID ancestor, Entity::ID id) const
+		{
+			for (const Entity* ent = _entities.try_get(id); ent; ent = _entities.try_get(ent->parent))
+			{
+				if (id == ancestor) return true;
+				id = ent->parent;
+			}
+			return false;
+		}
+
+		/// @brief Re-links `id` on the next flush(); across threads, the one that started recording last this frame wins.
+		void setParentDeferred(Entity::ID id, Entity::ID parent)
+		{
+			_deferred.pushSetParent(id, parent);
 		}
 
 		void destroyEntity(Entity::ID id)
@@ -141,31 +344,95 @@ namespace csyren::core
 
 			auto pool = getOrCreatePool<T>(family);
 			T* ptr = pool->emplace(id, std::forward<Args>(args)...);
+			if (ptr && _inactive.test(id))
+			{
+				pool->deactivate(id);
+			}
 			if (ptr)
 			{
 				ent->components[family] = true;
+				notifyComponentEvent(family, id, ObserveOn::Added);
 				_bus.publish(getAddToken<T>(),
 					events::ComponentCreateEvent<T>{id, ptr});
 			}
 			return ptr;
 		}
 
+		/**
+		 * @brief Records a component add that is played back on the next flush().
+		 *
+		 * The value is constructed now into the command arena. Playback skips the
+		 * command if the entity already has `T` or no longer exists. Commands one
+		 * thread records on the same entity and `T` play back in record order.
+		 */
+		template<typename T, typename... Args>
+		void addComponentDeferred(Entity::ID id, Args&&... args)
+		{
+			_deferred.pushEmplaceComponent<typename component_payload<T>::type>(id, reflection::ComponentFamily::getID<T>(), false,
+				&ComponentOps<T>::emplaceThunk, std::forward<Args>(args)...);
+		}
+
+		/**
+		 * @brief Like addComponentDeferred, but overwrites an existing `T` instead of skipping.
+		 *
+		 * If several threads replace `T` on one entity, the value of the thread that
+		 * started recording last this frame wins (see DeferredCommands).
+		 */
+		template<typename T, typename... Args>
+		void replaceComponentDeferred(Entity::ID id, Args&&... args)
+		{
+			_deferred.pushEmplaceComponent<typename component_payload<T>::type>(id, reflection::ComponentFamily::getID<T>(), true,
+				&ComponentOps<T>::emplaceThunk, std::forward<Args>(args)...);
+		}
+
+		/**
+		 * @brief Disabled entities keep their components but are skipped by views.
+		 *
+		 * No components are removed and no events are published; the entity's
+		 * components move to the inactive tail of their pools.
+		 */
+		void setEnabled(Entity::ID id, bool enabled)
+		{
+			if (!_entities.contains(id)) return;
+			_disabled.set(id, !enabled);
+			updateActivity(id);
+		}
+
+		/// @brief Sleeping is the simulation-driven counterpart of setEnabled(id, false).
+		void sleep(Entity::ID id)
+		{
+			if (!_entities.contains(id)) return;
+			_sleeping.set(id);
+			updateActivity(id);
+		}
+
+		void wake(Entity::ID id)
+		{
+			if (!_entities.contains(id)) return;
+			_sleeping.reset(id);
+			updateActivity(id);
+		}
+
+		[[nodiscard]] bool isEnabled(Entity::ID id) const noexcept { return !_disabled.test(id); }
+		[[nodiscard]] bool isSleeping(Entity::ID id) const noexcept { return _sleeping.test(id); }
+		/// @brief Enabled and not sleeping.
+		[[nodiscard]] bool isActive(Entity::ID id) const noexcept { return !_inactive.test(id); }
+
+		/**
+		 * @brief Records a component removal played back on the next flush().
+		 *
+		 * Ordered against deferred adds/replaces of the same `T` on `id`, so a
+		 * remove followed by addComponentDeferred leaves the new value in place.
+		 */
 		template<typename T>
 		void removeComponent(Entity::ID id)
 		{
-			Entity* ent = _entities.try_get(id);
-			if (!ent) return;
-
-			const size_t family = reflection::ComponentFamily::getID<T>();
-			if (!ent->components.test(family)) return;
-			_deferred.pushDestroyComponent(id, family);
+			removeComponent(id, reflection::ComponentFamily::getID<T>());
 		}
 
 		void removeComponent(Entity::ID id, size_t family)
 		{
-			Entity* ent = _entities.try_get(id);
-			if (!ent) return;
-			if (!ent->components.test(family)) return;
+			if (!_entities.contains(id)) return;
 			_deferred.pushDestroyComponent(id, family);
 		}
 
@@ -176,21 +443,244 @@ namespace csyren::core
 			return getPool<T>() ? getPool<T>()->try_get(id) : nullptr;
 		}
 
+		/**
+		 * @brief Points the `Shared<T>` of `id` at the group of `value` (changed for observers).
+		 */
+		template<typename T>
+		const Shared<T>* setSharedComponent(Entity::ID id, T value)
+		{
+			auto pool = getPool<Shared<T>>();
+			Shared<T>* handle = pool ? pool->assign(id, std::move(value)) : nullptr;
+			if (handle)
+				notifyComponentEvent(reflection::ComponentFamily::getID<Shared<T>>(), id, ObserveOn::Changed);
+			return handle;
+		}
+
+		/**
+		 * @brief Calls `fn(const T&, std::span<const Entity::ID>)` once per distinct `Shared<T>` value.
+		 *
+		 * Each span is a ready instancing batch of active entities that also match
+		 * `Filter...` (view terms). Groups left empty by the filter are skipped.
+		 */
+		template<typename T, typename... Filter, typename Fn>
+		void eachGroup(Fn&& fn)
+		{
+			using Terms = detail::view_terms<Filter...>;
+			auto pool = getPool<Shared<T>>();
+			if (!pool) return;
+
+			const auto with = maskOf(typename Terms::include_list{});
+			const auto without = maskOf(typename Terms::exclude_list{});
+			std::vector<Entity::ID> batch;
+			pool->eachGroup([&](const T& value, std::span<const Entity::ID> members)
+				{
+					batch.clear();
+					for (const Entity::ID id : members)
+					{
+						if (_inactive.test(id)) continue;
+						const Entity* ent = _entities.try_get(id);
+						if ((ent->components & with) == with && (ent->components & without).none())
+							batch.push_back(id);
+					}
+					if (!batch.empty())
+						fn(value, std::span<const Entity::ID>(batch));
+				});
+		}
+
+		/**
+		 * @brief Flags `T` on `id` as modified for Changed observers and re-keys its indexes.
+		 */
+		template<typename T>
+		void markChanged(Entity::ID id)
+		{
+			const size_t family = reflection::ComponentFamily::getID<T>();
+			const Entity* ent = _entities.try_get(id);
+			if (!ent || !ent->components.test(family)) return;
+			notifyComponentEvent(family, id, ObserveOn::Changed);
+		}
+
+		/**
+		 * @brief Calls `fn(T&)` on the component and marks it changed.
+		 */
+		template<typename T, typename Fn>
+		T* patch(Entity::ID id, Fn&& fn)
+		{
+			T* comp = getComponent<T>(id);
+			if (!comp) return nullptr;
+			fn(*comp);
+			markChanged<T>(id);
+			return comp;
+		}
+
+		/**
+		 * @brief Creates an observer that collects entities when `T` is added/removed/changed.
+		 *
+		 * `Filter...` accepts the same terms as view() (plain types and exclude<>); it is
+		 * checked when the observer is drained. The observer lives until unobserve().
+		 */
+		template<typename T, typename... Filter>
+		Observer& observe(ObserveOn events)
+		{
+			using Terms = detail::view_terms<Filter...>;
+			const size_t family = reflection::ComponentFamily::getID<T>();
+			getOrCreatePool<T>(family);
+
+			auto obs = std::make_unique<Observer>(_entities, family, events,
+				maskOf(typename Terms::include_list{}), maskOf(typename Terms::exclude_list{}));
+			_meta[family].observers.push_back(obs.get());
+			_observers.push_back(std::move(obs));
+			return *_observers.back();
+		}
+
+		void unobserve(Observer& observer)
+		{
+			auto it = _meta.find(observer.family());
+			if (it != _meta.end())
+			{
+				auto& list = it->second.observers;
+				list.erase(std::remove(list.begin(), list.end(), &observer), list.end());
+			}
+			std::erase_if(_observers, [&observer](const auto& o) { return o.get() == &observer; });
+		}
+
+		/**
+		 * @brief Creates an ordered index over `extract(const T&)`, e.g. `&MeshRenderer::material`.
+		 *
+		 * Existing components are indexed immediately. The key type must be copyable
+		 * and ordered by `operator<`. The index lives until dropIndex().
+		 */
+		template<typename T, typename Extract>
+		ComponentIndex<T, std::decay_t<Extract>>& createIndex(Extract&& extract)
+		{
+			static_assert(!std::is_empty_v<T>, "Scene::createIndex: tag components carry no value to index");
+			const size_t family = reflection::ComponentFamily::getID<T>();
+			auto index = std::make_unique<ComponentIndex<T, std::decay_t<Extract>>>(
+				family, getOrCreatePool<T>(family), std::forward<Extract>(extract));
+			auto& ref = *index;
+			_meta[family].indexes.push_back(index.get());
+			_indexes.push_back(std::move(index));
+			return ref;
+		}
+
+		void dropIndex(IndexBase& index)
+		{
+			auto it = _meta.find(index.family());
+			if (it != _meta.end())
+			{
+				auto& list = it->second.indexes;
+				list.erase(std::remove(list.begin(), list.end(), &index), list.end());
+			}
+			std::erase_if(_indexes, [&index](const auto& i) { return i.get() == &index; });
+		}
+
+		/**
+		 * @brief Reorders the pool of `T` by `compare(const T&, const T&)`.
+		 *
+		 * Views driven by this pool visit entities in that order afterwards.
+		 */
+		template<typename T, typename Compare>
+		void sort(Compare&& compare)
+		{
+			static_assert(!std::is_empty_v<T>, "Scene::sort: tag components carry no value to sort by");
+			if (auto pool = getPool<T>())
+				pool->sort(std::forward<Compare>(compare));
+		}
+
 		template<typename... Cs>
 		SceneView<Cs...> view(){ return SceneView<Cs...>(this); }
 
-		const cstdmf::SparseSet<Entity>& entities() const { return _entities; }
+		/// @brief Starts a query over component family IDs; see RuntimeQuery.
+		RuntimeQuery query();
 
+		const cstdmf::SparseSet<Entity>& entities() const { return _entities; }
 
-		void flush()
+		/**
+		 * @brief Moves every entity and component of `staging` into this scene.
+		 *
+		 * Entities receive fresh IDs; parent/child links inside the staging scene are
+		 * remapped. Component pools are spliced in bulk. `staging` is left empty.
+		 * @return mapping from staging ID to live ID (`Entity::invalidID` for unused slots).
+		 */
+		std::vector<Entity::ID> merge(Scene& staging)
 		{
-			for (const auto& e : _deferred.destroyComponentBuf())
+			staging.flush();
+
+			std::vector<Entity::ID> remap(staging._nextId, Entity::invalidID);
+			for (auto it = staging._entities.key_begin(); it != staging._entities.key_end(); ++it)
 			{
-				auto it = _meta.find(e.family);
-				if (it == _meta.end())
-					continue;
-				it->second.removeFn(this, e, it->second.removeToken, _bus);
+				remap[*it] = allocateID();
+				for (auto& obs : _observers)
+					obs->recycle(remap[*it]);
 			}
+			auto translate = [&remap](Entity::ID id)
+				{
+					return id < remap.size() ? remap[id] : Entity::invalidID;
+				};
+
+			const size_t first = _entities.size();
+			_entities.append(std::move(staging._entities), translate);
+			for (size_t i = first; i < _entities.size(); ++i)
+			{
+				Entity& ent = _entities.data()[i];
+				ent.id = _entities.key_data()[i];
+				ent.parent = translate(ent.parent);
+				for (auto& child : ent.childrens)
+					child = translate(child);
+				_bus.publish(_entityCreateToken, events::EntityCreateEvent{ ent.id });
+			}
+
+			for (auto& [family, m] : staging._meta)
+			{
+				if (m.pool && m.mergeFn)
+					m.mergeFn(this, *m.pool, remap);
+			}
+
+			for (Entity::ID id = 0; id < remap.size(); ++id)
+			{
+				if (remap[id] == Entity::invalidID) continue;
+				if (staging._disabled.test(id)) setEnabled(remap[id], false);
+				if (staging._sleeping.test(id)) sleep(remap[id]);
+			}
+			staging._disabled.clear();
+			staging._sleeping.clear();
+			staging._inactive.clear();
+
+			staging._freeIDs.clear();
+			staging._nextId = 0;
+			staging._idCursor.store(0, std::memory_order_relaxed);
+			return remap;
+		}
+
+		/**
+		 * @brief Queues a staging world to be merged on the next flush(). Thread-safe.
+		 */
+		void enqueueMerge(std::unique_ptr<StagingWorld> staging)
+		{
+			if (!staging) return;
+			std::lock_guard lock(_stagedMutex);
+			_staged.push_back(std::move(staging));
+		}
+
+
+		void flush()
+		{
+			reconcileIDs();
+			_deferred.gather();
+			for (const auto& c : _deferred.createEntityBuf())
+				materializeEntity(c.id);
+			for (const auto& c : _deferred.createEntityBuf())
+				setParent(c.id, c.parent);
+			for (const auto& c : _deferred.setParentBuf())
+				setParent(c.entt, c.parent);
+
+			_deferred.forEachComponentCommand(
+				[this](EmplaceComponentCommand& c) { c.apply(this, c); },
+				[this](const DestroyComponentCommand& e)
+				{
+					auto it = _meta.find(e.family);
+					if (it != _meta.end())
+						it->second.removeFn(this, e, it->second.removeToken, _bus);
+				});
 
 			DestroyComponentCommand cm;
 			for (const auto& e : _deferred.destroyEntityBuf())
@@ -230,6 +720,9 @@ namespace csyren::core
 					pChild->parent = Entity::invalidID;
 				}
 				_entities.erase(e.id);
+				_disabled.reset(e.id);
+				_sleeping.reset(e.id);
+				_inactive.reset(e.id);
 				if (e.id + 1 == _nextId)
 				{
 					--_nextId;
@@ -239,11 +732,100 @@ namespace csyren::core
 					_freeIDs.push_back(e.id);
 				}
 			}
+			_idCursor.store(static_cast<int64_t>(_freeIDs.size()), std::memory_order_relaxed);
 
 			_deferred.clear();
+
+			std::vector<std::unique_ptr<StagingWorld>> staged;
+			{
+				std::lock_guard lock(_stagedMutex);
+				staged.swap(_staged);
+			}
+			for (auto& world : staged)
+				merge(world->scene());
 		}
 
 	private:
+		template<typename... Ts>
+		static std::bitset<reflection::MAX_COMPONENT_TYPES> maskOf(detail::type_list<Ts...>)
+		{
+			std::bitset<reflection::MAX_COMPONENT_TYPES> mask;
+			(mask.set(reflection::ComponentFamily::getID<Ts>()), ...);
+			return mask;
+		}
+
+		void updateActivity(Entity::ID id)
+		{
+			const bool inactive = _disabled.test(id) || _sleeping.test(id);
+			if (inactive == _inactive.test(id)) return;
+			_inactive.set(id, inactive);
+
+			const Entity* ent = _entities.try_get(id);
+			for (auto& [family, m] : _meta)
+			{
+				if (m.pool && ent->components.test(family))
+					m.pool->setActive(id, !inactive);
+			}
+		}
+
+		/// Feeds observers and indexes of `family`. Called before the component is erased on Removed.
+		void notifyComponentEvent(size_t family, Entity::ID id, ObserveOn event)
+		{
+			if (_observers.empty() && _indexes.empty()) return;
+			auto it = _meta.find(family);
+			if (it == _meta.end()) return;
+			for (Observer* obs : it->second.observers)
+				obs->notify(id, event);
+			for (IndexBase* index : it->second.indexes)
+				index->onEvent(id, event);
+		}
+
+		void materializeEntity(Entity::ID id)
+		{
+			Entity* ent = _entities.emplace(id, Entity{});
+			ent->id = id;
+			for (auto& obs : _observers)
+				obs->recycle(id);
+			_bus.publish(_entityCreateToken, events::EntityCreateEvent{ id });
+		}
+
+		/**
+		 * Lock-free, callable from any thread. A positive cursor indexes the free list
+		 * (taken from the back); once it goes negative IDs continue past `_nextId`.
+		 * `_freeIDs` and `_nextId` themselves only change in reconcileIDs().
+		 */
+		Entity::ID allocateID()
+		{
+			const int64_t cursor = _idCursor.fetch_sub(1, std::memory_order_relaxed);
+			if (cursor > 0)
+			{
+				return _freeIDs[static_cast<size_t>(cursor - 1)];
+			}
+			const uint64_t id = static_cast<uint64_t>(_nextId) + static_cast<uint64_t>(-cursor);
+			if (id >= Entity::invalidID)
+			{
+				throw std::runtime_error("Scene: out of Entity IDs");
+			}
+			return static_cast<Entity::ID>(id);
+		}
+
+		/// Folds reservations made since the last flush into `_freeIDs` / `_nextId`.
+		void reconcileIDs()
+		{
+			const int64_t cursor = _idCursor.load(std::memory_order_relaxed);
+			if (cursor >= 0)
+			{
+				_freeIDs.resize(static_cast<size_t>(cursor));
+			}
+			else
+			{
+				_freeIDs.clear();
+				const uint64_t next = static_cast<uint64_t>(_nextId) + static_cast<uint64_t>(-cursor);
+				_nextId = static_cast<Entity::ID>(std::min<uint64_t>(next, Entity::invalidID));
+			}
+			_idCursor.store(static_cast<int64_t>(_freeIDs.size()), std::memory_order_relaxed);
+		}
+
 		template<typename T>
 		std::shared_ptr<ComponentPool<T>> getPool()
 		{
@@ -272,6 +854,7 @@ namespace csyren::core
 			m.addToken = _bus.register_publisher<events::ComponentCreateEvent<T>>();
 			m.removeToken = _bus.register_publisher<events::ComponentDestroyEvent<T>>();
 			m.removeFn = &ComponentOps<T>::destroyThunk;
+			m.mergeFn = &ComponentOps<T>::mergeThunk;
 		}
 		template<typename T>
 		events::PublishToken& getAddToken()
@@ -294,9 +877,19 @@ namespace csyren::core
 		cstdmf::SparseSet<Entity>	_entities;
 		std::vector<Entity::ID>		_freeIDs;
 		Entity::ID              _nextId = 0;
+		std::atomic<int64_t>		_idCursor{ 0 };	// see allocateID()
 		ComponentsMeta				_meta;
 
 		DeferredCommands _deferred;
+		std::vector<std::unique_ptr<Observer>> _observers;
+		std::vector<std::unique_ptr<IndexBase>> _indexes;
+
+		cstdmf::DynamicBitset _disabled;
+		cstdmf::DynamicBitset _sleeping;
+		cstdmf::DynamicBitset _inactive;
+
+		std::vector<std::unique_ptr<StagingWorld>> _staged;
+		std::mutex _stagedMutex;
 
 		events::PublishToken _entityCreateToken;
 		events::PublishToken _entityDestroyToken;
@@ -306,14 +899,37 @@ namespace csyren::core
 	};
 
 
+	inline StagingWorld::StagingWorld() : _scene(std::make_unique<Scene>(_bus)) {}
+	inline StagingWorld::~StagingWorld() = default;
+
 	template<class... Cs>
 	class SceneView
 	{
+		using Terms = detail::view_terms<Cs...>;
+		using Required = typename Terms::include_list;
+		using Excluded = typename Terms::exclude_list;
+		using Optional = typename Terms::optional_list;
+
 		template<class T>
 		using PoolPtr = std::shared_ptr<ComponentPool<T>>;
-		using Pools = std::tuple<PoolPtr<Cs>...>;
 		using DenseContainer = std::vector<Entity::ID>;
 		using DenseIt = DenseContainer::const_iterator;
+		using Mask = std::bitset<reflection::MAX_COMPONENT_TYPES>;
+
+		// tag components (empty types) take part in matching but are not passed to the caller
+		template<class C>
+		using RefTuple = std::conditional_t<std::is_empty_v<C>, std::tuple<>, std::tuple<C&>>;
+		template<class C>
+		using ConstRefTuple = std::conditional_t<std::is_empty_v<C>, std::tuple<>, std::tuple<const C&>>;
+
+		template<class... Ts> static std::tuple<PoolPtr<Ts>...> pools_of(detail::type_list<Ts...>);
+		template<class... Ts> static auto refs_of(detail::type_list<Ts...>) -> decltype(std::tuple_cat(std::declval<RefTuple<Ts>>()...));
+		template<class... Ts> static auto const_refs_of(detail::type_list<Ts...>) -> decltype(std::tuple_cat(std::declval<ConstRefTuple<Ts>>()...));
+		template<class... Ts> static std::tuple<Ts*...> ptrs_of(detail::type_list<Ts...>);
+		template<class... Ts> static std::tuple<const Ts*...> const_ptrs_of(detail::type_list<Ts...>);
+
+		using Pools = decltype(pools_of(Required{}));
+		using OptionalPools = decltype(pools_of(Optional{}));
 
 		template <typename F, typename Tuple, typename = void>
 		struct is_apply_invocable : std::false_type {};
@@ -324,11 +940,29 @@ namespace csyren::core
 		> : std::true_type {
 		};
 	public:
-		SceneView(Scene* scene) : _scene(scene),_empty(true){}
+		/// (id, required components..., optional component pointers...); tags are omitted.
+		using value_type = decltype(std::tuple_cat(std::declval<std::tuple<Entity::ID>>(),
+			refs_of(Required{}), ptrs_of(Optional{})));
+		using const_value_type = decltype(std::tuple_cat(std::declval<std::tuple<Entity::ID>>(),
+			const_refs_of(Required{}), const_ptrs_of(Optional{})));
+
+		SceneView(Scene* scene) : _scene(scene),_empty(true)
+		{
+			[this]<class... Rs>(detail::type_list<Rs...>)
+			{
+				(_include.set(reflection::ComponentFamily::getID<Rs>()), ...);
+			}(Required{});
+			[this]<class... Es>(detail::type_list<Es...>)
+			{
+				(_exclude.set(reflection::ComponentFamily::getID<Es>()), ...);
+			}(Excluded{});
+			// a lone required pool already guarantees its own membership
+			_checkMask = _include.count() != 1 || _exclude.any();
+		}
 		class iterator
 		{
 		public:
-			using value_type = std::tuple<Entity::ID, Cs&...>;
+			using value_type = SceneView::value_type;
 			using iterator_category = std::forward_iterator_tag;
 			using difference_type = std::ptrdiff_t;
 
@@ -351,7 +985,7 @@ namespace csyren::core
 
 			void skip()
 			{
-				while (_it != _view->_last && !_view->has_all_components(*_it))
+				while (_it != _view->_last && !_view->matches(*_it))
 					++_it;
 			}
 			SceneView* _view;
@@ -361,7 +995,7 @@ namespace csyren::core
 		class const_iterator
 		{
 		public:
-			using value_type = std::tuple<Entity::ID, const Cs&...>;
+			using value_type = SceneView::const_value_type;
 			using iterator_category = std::forward_iterator_tag;
 
 			const_iterator(const SceneView* view, DenseIt it) : _view(view), _it(it) { skip(); }
@@ -387,7 +1021,7 @@ namespace csyren::core
 		private:
 			void skip()
 			{
-				while (_it != _view->_last && !_view->has_all_components(*_it))
+				while (_it != _view->_last && !_view->matches(*_it))
 					++_it;
 			}
 			const SceneView* _view;
@@ -400,6 +1034,9 @@ namespace csyren::core
 		[[nodiscard]] const_iterator begin() const { refresh(); return _empty ? end() : const_iterator(this, _first); }
 		[[nodiscard]] const_iterator end()   const { return const_iterator(this, _last); }
 
+		/// @brief Also visit disabled and sleeping entities (skipped by default).
+		SceneView& withInactive() noexcept { _includeInactive = true; return *this; }
+
 		template<class Fn>
 		void each(Fn&& fn)
 		{
@@ -410,32 +1047,112 @@ namespace csyren::core
 				std::apply(fn, *it);
 		}
 
+		/**
+		 * @brief Like each(), but visits only the entities of `ids` that match the view, in that order.
+		 *
+		 * Costs one entity lookup per listed ID instead of a walk over the smallest pool.
+		 */
+		template<class Fn>
+		void each(std::span<const Entity::ID> ids, Fn&& fn)
+		{
+			refresh();
+			if (_empty) return;
+			for (Entity::ID id : ids)
+			{
+				if (contains(id))
+					std::apply(fn, make_pointer_tuple(id));
+			}
+		}
+
+		/// @brief True if `id` has every required component, none of the excluded ones, and is visited by each().
+		[[nodiscard]] bool contains(Entity::ID id) const
+		{
+			const Entity* ent = _scene->_entities.try_get(id);
+			if (!ent) return false;
+			if (!_includeInactive && _scene->_inactive.test(id)) return false;
+			return (ent->components & _include) == _include && (ent->components & _exclude).none();
+		}
+
 	private:
+		template<class C>
+		ConstRefTuple<C> component_ref(Entity::ID id) const
+		{
+			if constexpr (std::is_empty_v<C>) return {};
+			else return ConstRefTuple<C>((*std::get<PoolPtr<C>>(_pools))[id]);
+		}
+		template<class C>
+		RefTuple<C> component_ref(Entity::ID id)
+		{
+			if constexpr (std::is_empty_v<C>) return {};
+			else return RefTuple<C>((*std::get<PoolPtr<C>>(_pools))[id]);
+		}
+
+		template<class C>
+		C* optional_ptr(Entity::ID id) const
+		{
+			const auto& pool = std::get<PoolPtr<C>>(_optional);
+			return pool ? pool->try_get(id) : nullptr;
+		}
+
 		auto make_pointer_tuple(Entity::ID id) const
 		{
-			return std::tuple<Entity::ID,const Cs&...>(id, (*std::get<PoolPtr<Cs>>(_pools))[id]...);
+			return [&]<class... Rs, class... Os>(detail::type_list<Rs...>, detail::type_list<Os...>)
+			{
+				return std::tuple_cat(std::tuple<Entity::ID>(id), component_ref<Rs>(id)...,
+					std::tuple<const Os*>(optional_ptr<Os>(id))...);
+			}(Required{}, Optional{});
 		}
 		auto make_pointer_tuple(Entity::ID id)
 		{
-			return std::tuple<Entity::ID, Cs&...>(id, (*std::get<PoolPtr<Cs>>(_pools))[id]...);
+			return [&]<class... Rs, class... Os>(detail::type_list<Rs...>, detail::type_list<Os...>)
+			{
+				return std::tuple_cat(std::tuple<Entity::ID>(id), component_ref<Rs>(id)...,
+					std::tuple<Os*>(optional_ptr<Os>(id))...);
+			}(Required{}, Optional{});
 		}
 		
 		void gather_pools() const
 		{
-			((std::get<PoolPtr<Cs>>(_pools) = _scene->template getPool<Cs>()), ...);
+			[this]<class... Rs>(detail::type_list<Rs...>)
+			{
+				((std::get<PoolPtr<Rs>>(_pools) = _scene->template getPool<Rs>()), ...);
+			}(Required{});
+			gather_optional_pools();
+		}
+
+		// an optional pool may be created after the view first ran
+		void gather_optional_pools() const
+		{
+			[this]<class... Os>(detail::type_list<Os...>)
+			{
+				(resolve_optional<Os>(), ...);
+			}(Optional{});
+		}
+
+		template<class O>
+		void resolve_optional() const
+		{
+			auto& pool = std::get<PoolPtr<O>>(_optional);
+			if (!pool) pool = _scene->template getPool<O>();
+		}
+
+		bool has_required_pools() const
+		{
+			return std::apply([](const auto&... pool) { return (static_cast<bool>(pool) && ...); }, _pools);
 		}
 
 		void refresh() const
 		{
 			if (!_empty)
 			{
+				gather_optional_pools();
 				pick_smallest();
 				return;
 			}
 
 			gather_pools();
 
-			if ((!std::get<PoolPtr<Cs>>(_pools) || ...))
+			if (!has_required_pools())
 			{
 				return;
 			}
@@ -445,27 +1162,171 @@ namespace csyren::core
 
 		void pick_smallest() const
 		{
-			DenseIt first{}, last{};
-			std::size_t minSize = std::numeric_limits<std::size_t>::max();
-			std::apply([&](auto&&... pool)
-				{
-					((pool->size() < minSize ? (minSize = pool->size(),first = pool->key_begin(),last = pool->key_end(),0): 0), ...);
-				}, _pools);
-
-			_first = first;
-			_last = last;
+			if constexpr (std::tuple_size_v<Pools> == 0)
+			{
+				// only exclude/optional terms: walk every entity
+				_first = _scene->_entities.key_begin();
+				_last = _scene->_entities.key_end();
+			}
+			else
+			{
+				DenseIt first{}, last{};
+				std::size_t minSize = std::numeric_limits<std::size_t>::max();
+				// inactive entities sit in the tail of every pool, so only the active prefix is walked
+				auto consider = [&](const auto& pool)
+					{
+						const std::size_t size = _includeInactive ? pool->size() : pool->active_size();
+						if (size < minSize)
+						{
+							minSize = size;
+							first = pool->key_begin();
+							last = _includeInactive ? pool->key_end() : pool->active_key_end();
+						}
+					};
+				std::apply([&](auto&&... pool) { (consider(pool), ...); }, _pools);
+
+				_first = first;
+				_last = last;
+			}
 		}
-		bool has_all_components(Entity::ID id) const
+
+		/// One sparse lookup and a mask compare instead of a contains() probe per pool.
+		bool matches(Entity::ID id) const
 		{
-			return (std::get<PoolPtr<Cs>>(_pools)->contains(id) && ...);
+			if constexpr (std::tuple_size_v<Pools> == 0)
+			{
+				if (!_includeInactive && _scene->_inactive.test(id)) return false;
+			}
+			if (!_checkMask) return true;
+			const Entity* ent = _scene->_entities.try_get(id);
+			if (!ent) return false;
+			return (ent->components & _include) == _include && (ent->components & _exclude).none();
 		}
 
 		mutable Pools _pools;
+		mutable OptionalPools _optional;
 		Scene* _scene;
+		Mask _include;
+		Mask _exclude;
+		bool _checkMask{ true };
+		bool _includeInactive{ false };
 		mutable DenseIt _first, _last;
 		mutable bool _empty{ false };
 	};
 
+
+	/**
+	 * @brief SceneView counterpart driven by component family IDs instead of types.
+	 *
+	 * Built with with()/without()/optional() and matched against Entity::components,
+	 * so tooling and scripts can query without instantiating templates. each()
+	 * passes type-erased column pointers in the order the families were added:
+	 * with() families first, then optional() ones (nullptr when absent). Tags yield
+	 * a non-null dummy pointer; Shared<T> columns point at the read-only shared value.
+	 */
+	class RuntimeQuery
+	{
+		using Mask = std::bitset<reflection::MAX_COMPONENT_TYPES>;
+	public:
+		explicit RuntimeQuery(Scene* scene) noexcept : _scene(scene) {}
+
+		RuntimeQuery& with(size_t family)
+		{
+			_include.set(family);
+			_with.push_back(family);
+			return *this;
+		}
+		RuntimeQuery& without(size_t family)
+		{
+			_exclude.set(family);
+			return *this;
+		}
+		RuntimeQuery& optional(size_t family)
+		{
+			_optional.push_back(family);
+			return *this;
+		}
+		/// @brief Also visit disabled and sleeping entities (skipped by default).
+		RuntimeQuery& withInactive() noexcept
+		{
+			_includeInactive = true;
+			return *this;
+		}
+
+		/// @brief Calls `fn(Entity::ID, std::span<void* const> columns)` for every match.
+		template<typename Fn>
+		void each(Fn&& fn) const
+		{
+			std::vector<PoolBase*> pools;
+			pools.reserve(_with.size() + _optional.size());
+			for (size_t family : _with)
+			{
+				PoolBase* pool = poolOf(family);
+				if (!pool) return;
+				pools.push_back(pool);
+			}
+			for (size_t family : _optional)
+				pools.push_back(poolOf(family));
+
+			// drive by the smallest required pool, or by every entity without one
+			size_t driver = _with.size();
+			const Entity::ID* keys = _scene->_entities.key_data();
+			size_t count = _scene->_entities.size();
+			for (size_t i = 0; i < _with.size(); ++i)
+			{
+				const size_t size = _includeInactive ? pools[i]->poolSize() : pools[i]->poolActiveSize();
+				if (driver == _with.size() || size < count)
+				{
+					driver = i;
+					count = size;
+					keys = pools[i]->poolKeys();
+				}
+			}
+			const bool checkMask = _with.size() != 1 || _exclude.any();
+
+			std::vector<void*> columns(pools.size());
+			for (size_t index = 0; index < count; ++index)
+			{
+				const Entity::ID id = keys[index];
+				if (driver == _with.size() && !_includeInactive && _scene->_inactive.test(id)) continue;
+				if (checkMask)
+				{
+					const Entity* ent = _scene->_entities.try_get(id);
+					if (!ent || (ent->components & _include) != _include || (ent->components & _exclude).any())
+						continue;
+				}
+				for (size_t c = 0; c < pools.size(); ++c)
+				{
+					if (c == driver) columns[c] = pools[c]->poolAt(index);
+					else columns[c] = pools[c] ? pools[c]->poolGet(id) : nullptr;
+				}
+				fn(id, std::span<void* const>(columns));
+			}
+		}
+
+		[[nodiscard]] size_t count() const
+		{
+			size_t n = 0;
+			each([&n](Entity::ID, std::span<void* const>) { ++n; });
+			return n;
+		}
+
+	private:
+		PoolBase* poolOf(size_t family) const
+		{
+			auto it = _scene->_meta.find(family);
+			return it != _scene->_meta.end() ? it->second.pool.get() : nullptr;
+		}
+
+		Scene* _scene;
+		Mask _include;
+		Mask _exclude;
+		std::vector<size_t> _with;
+		std::vector<size_t> _optional;
+		bool _includeInactive{ false };
+	};
+
+	inline RuntimeQuery Scene::query() { return RuntimeQuery(this); }
 }
 
 #endif;
@@ -0,0 +1,217 @@
+#ifndef __CSYREN_SHARED_COMPONENT__
+#define __CSYREN_SHARED_COMPONENT__
+
+#include "component_pool.h"
+
+#include <map>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace csyren::core
+{
+	/**
+	 * @brief Flyweight component: every entity with an equal `T` references one stored value.
+	 *
+	 * Used as `Shared<MeshRenderer>` wherever a component type is expected
+	 * (addComponent, view, removeComponent, observers). `T` must be ordered by
+	 * `operator<`; equal values (neither less than the other) share storage.
+	 * The value is read-only through the handle: assign a new one with
+	 * Scene::setSharedComponent or replaceComponentDeferred.
+	 */
+	template<typename T>
+	class Shared
+	{
+		template<class, bool> friend class ComponentPool;
+	public:
+		using value_type = T;
+
+		Shared(const Shared&) noexcept = default;
+
+		[[nodiscard]] const T& get() const noexcept { return *_value; }
+		[[nodiscard]] const T& operator*() const noexcept { return *_value; }
+		[[nodiscard]] const T* operator->() const noexcept { return _value; }
+
+		/// @brief Stable id of the value group, usable as a batch key.
+		[[nodiscard]] uint32_t group() const noexcept { return _group; }
+
+	private:
+		Shared(const T* value, uint32_t group, uint32_t slot) noexcept
+			: _value(value), _group(group), _slot(slot) {}
+		// only the pool may re-point a handle: assigning one through a view would
+		// leave the group member lists out of sync
+		Shared& operator=(const Shared&) noexcept = default;
+
+		const T* _value;
+		uint32_t _group;
+		uint32_t _slot;	// position inside the group's member list
+	};
+
+	template<typename T>
+	struct is_shared_component : std::false_type {};
+	template<typename T>
+	struct is_shared_component<Shared<T>> : std::true_type {};
+	template<typename T>
+	inline constexpr bool is_shared_component_v = is_shared_component<T>::value;
+
+	/// Type recorded by deferred commands: the plain value for shared components.
+	template<typename T>
+	struct component_payload { using type = T; };
+	template<typename T>
+	struct component_payload<Shared<T>> { using type = T; };
+
+	/**
+	 * @brief Pool for `Shared<T>`: per-entity handles plus one refcounted value per group.
+	 *
+	 * Each group keeps its own member list, so eachGroup() hands out ready-made
+	 * instancing batches without sorting. A group is freed when its last member leaves.
+	 */
+	template<class T>
+	class ComponentPool<Shared<T>, false> : public PoolStorage<cstdmf::SparseSet<Shared<T>>>
+	{
+		using Handle = Shared<T>;
+		using Handles = cstdmf::SparseSet<Handle>;
+		using Storage = PartitionedStorage<Handles>;
+
+		struct Group
+		{
+			T value;
+			std::vector<Entity::ID> members;
+		};
+		struct ValueLess
+		{
+			bool operator()(const T* a, const T* b) const { return *a < *b; }
+		};
+	public:
+		template<typename... Args>
+		Handle* emplace(Entity::ID entity, Args&&... args)
+		{
+			const uint32_t group = acquire(T(std::forward<Args>(args)...));
+			auto& members = _groups[group]->members;
+			Storage::emplace(entity, Handle(&_groups[group]->value, group, static_cast<uint32_t>(members.size())));
+			members.push_back(entity);
+			this->adoptLast();
+			return this->try_get(entity);
+		}
+
+		bool erase(Entity::ID entity)
+		{
+			const Handle* handle = this->try_get(entity);
+			if (!handle) return false;
+			release(*handle);
+			return Storage::erase(entity);
+		}
+
+		/// @brief Moves `entity` to the group of `value`; returns nullptr if it has no handle.
+		Handle* assign(Entity::ID entity, T value)
+		{
+			Handle* handle = this->try_get(entity);
+			if (!handle) return nullptr;
+
+			const uint32_t group = acquire(std::move(value));
+			if (group == handle->_group)
+			{
+				releaseIfUnused(group);
+				return handle;
+			}
+			release(*handle);
+			auto& members = _groups[group]->members;
+			*handle = Handle(&_groups[group]->value, group, static_cast<uint32_t>(members.size()));
+			members.push_back(entity);
+			return handle;
+		}
+
+		template<typename Remap>
+		void append(ComponentPool&& other, Remap&& remap)
+		{
+			for (auto it = other.key_begin(); it != other.key_end(); ++it)
+			{
+				if (this->contains(remap(*it)))
+					throw std::runtime_error("ComponentPool::append: entity already present");
+			}
+			for (auto it = other.key_begin(); it != other.key_end(); ++it)
+				emplace(remap(*it), other[*it].get());
+			other.clear();
+		}
+
+		void clear()
+		{
+			Storage::clear();
+			_groups.clear();
+			_freeGroups.clear();
+			_lookup.clear();
+		}
+
+		// type-erased access yields the shared value itself; it must be treated as read-only
+		[[nodiscard]] void* poolGet(Entity::ID entity) noexcept override
+		{
+			const Handle* handle = this->try_get(entity);
+			return handle ? const_cast<T*>(&handle->get()) : nullptr;
+		}
+		[[nodiscard]] void* poolAt(size_t index) noexcept override { return const_cast<T*>(&this->data()[index].get()); }
+		[[nodiscard]] size_t componentSize() const noexcept override { return sizeof(T); }
+
+		/// @brief Calls `fn(const T&, std::span<const Entity::ID>)` once per live group.
+		template<typename Fn>
+		void eachGroup(Fn&& fn) const
+		{
+			for (const auto& group : _groups)
+			{
+				if (group && !group->members.empty())
+					fn(static_cast<const T&>(group->value), std::span<const Entity::ID>(group->members));
+			}
+		}
+
+		[[nodiscard]] size_t groupCount() const noexcept { return _lookup.size(); }
+
+	private:
+		uint32_t acquire(T value)
+		{
+			if (auto it = _lookup.find(&value); it != _lookup.end())
+				return it->second;
+
+			uint32_t group;
+			if (!_freeGroups.empty())
+			{
+				group = _freeGroups.back();
+				_freeGroups.pop_back();
+			}
+			else
+			{
+				group = static_cast<uint32_t>(_groups.size());
+				_groups.emplace_back();
+			}
+			_groups[group] = std::make_unique<Group>(Group{ std::move(value), {} });
+			_lookup.emplace(&_groups[group]->value, group);
+			return group;
+		}
+
+		void release(const Handle& handle)
+		{
+			auto& members = _groups[handle._group]->members;
+			const uint32_t slot = handle._slot;
+			if (slot + 1 != members.size())
+			{
+				members[slot] = members.back();
+				Storage::operator[](members[slot])._slot = slot;
+			}
+			members.pop_back();
+			releaseIfUnused(handle._group);
+		}
+
+		void releaseIfUnused(uint32_t group)
+		{
+			if (!_groups[group]->members.empty()) return;
+			_lookup.erase(&_groups[group]->value);
+			_groups[group].reset();
+			_freeGroups.push_back(group);
+		}
+
+		std::vector<std::unique_ptr<Group>> _groups;
+		std::vector<uint32_t> _freeGroups;
+		std::map<const T*, uint32_t, ValueLess> _lookup;
+	};
+}
+
+#endif
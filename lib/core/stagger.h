@@ -0,0 +1,148 @@
+#ifndef __CSYREN_STAGGER__
+#define __CSYREN_STAGGER__
+
+#include "entity.h"
+#include "time.h"
+
+#include "cstdmf/sparse_set.h"
+
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace csyren::core
+{
+	/**
+	 * @brief Spreads entities over K frames for low-priority work.
+	 *
+	 * Entities are registered with add() (typically from an Added observer) and
+	 * each one hashes into a fixed bucket by its ID. Each frame only the members
+	 * of bucket `frameCount % K` are looked up, so the per-frame cost is N/K, not N.
+	 * The callback gets the scaled time elapsed since that member was last visited,
+	 * or since the start of the frame it was added in, so integration stays correct
+	 * at 1/K rate. Keep one instance per system.
+	 *
+	 * Members are plain IDs, so destroyed entities must be remove()d: otherwise a
+	 * new entity that recycles the ID is visited without ever being added. Drain
+	 * a Removed observer before the Added one so a recycled ID ends up registered
+	 * only if the new entity qualifies.
+	 * @code
+	 * _brainsGone.drain([this](Entity::ID id) { _farAi.remove(id); });			// ObserveOn::Removed
+	 * _brains.drain([this, &event](Entity::ID id) { _farAi.add(id, event.time); });	// ObserveOn::Added
+	 * _farAi.each(scene.view<Transform, Brain>(), event.time,
+	 *     [](float dt, Entity::ID id, Transform& tr, Brain& brain) { ... });
+	 * @endcode
+	 */
+	class StaggeredUpdate
+	{
+	public:
+		explicit StaggeredUpdate(uint32_t buckets)
+		{
+			setBuckets(buckets);
+		}
+
+		/// @brief Changes K and re-buckets the members; each member keeps its clock.
+		void setBuckets(uint32_t buckets)
+		{
+			if (buckets == 0) throw std::invalid_argument("StaggeredUpdate: bucket count must be positive");
+
+			std::vector<std::vector<Entity::ID>> members(buckets);
+			std::vector<std::vector<float>> lastRun(buckets);
+			for (size_t bucket = 0; bucket < _members.size(); ++bucket)
+			{
+				for (size_t i = 0; i < _members[bucket].size(); ++i)
+				{
+					const Entity::ID id = _members[bucket][i];
+					const uint32_t to = bucketOf(id, buckets);
+					*_position.try_get(id) = static_cast<uint32_t>(members[to].size());
+					members[to].push_back(id);
+					lastRun[to].push_back(_lastRun[bucket][i]);
+				}
+			}
+			_members = std::move(members);
+			_lastRun = std::move(lastRun);
+		}
+
+		/**
+		 * @brief Starts visiting `id`; adding a member again is a no-op.
+		 *
+		 * The member's clock starts at the beginning of the current frame of `time`,
+		 * so its first dt covers only the frames it has been a member for.
+		 */
+		void add(Entity::ID id, const Time& time)
+		{
+			if (_position.contains(id)) return;
+			const uint32_t bucket = bucketOf(id);
+			_position.emplace(id, static_cast<uint32_t>(_members[bucket].size()));
+			_members[bucket].push_back(id);
+			_lastRun[bucket].push_back(time.totalTime() - time.deltaTime());
+		}
+
+		/// @brief Stops visiting `id`; destroyed members need it too (see the class comment).
+		void remove(Entity::ID id)
+		{
+			const uint32_t* position = _position.try_get(id);
+			if (!position) return;
+			const uint32_t bucket = bucketOf(id);
+			auto& list = _members[bucket];
+			auto& clocks = _lastRun[bucket];
+			const Entity::ID moved = list.back();
+			list[*position] = moved;
+			clocks[*position] = clocks.back();
+			*_position.try_get(moved) = *position;
+			list.pop_back();
+			clocks.pop_back();
+			_position.erase(id);
+		}
+
+		[[nodiscard]] bool contains(Entity::ID id) const noexcept { return _position.contains(id); }
+		[[nodiscard]] size_t size() const noexcept { return _position.size(); }
+
+		[[nodiscard]] uint32_t buckets() const noexcept { return static_cast<uint32_t>(_members.size()); }
+
+		/// @brief Stable bucket of `id`; a Fibonacci hash keeps sequential IDs evenly spread.
+		[[nodiscard]] static uint32_t bucketOf(Entity::ID id, uint32_t buckets) noexcept
+		{
+			const uint64_t hash = (static_cast<uint64_t>(id) * 0x9E3779B97F4A7C15ull) >> 32;
+			return static_cast<uint32_t>(hash % buckets);
+		}
+
+		[[nodiscard]] uint32_t bucketOf(Entity::ID id) const noexcept { return bucketOf(id, buckets()); }
+
+		[[nodiscard]] uint32_t currentBucket(const Time& time) const noexcept
+		{
+			return static_cast<uint32_t>(time.frameCount() % buckets());
+		}
+
+		/**
+		 * @brief Calls `fn(float dt, Entity::ID, components...)` for this frame's members that match `view`.
+		 *
+		 * Works with anything whose each(ids, fn) passes the entity ID first (SceneView).
+		 * Call it once per frame, and add()/remove() members outside of it.
+		 */
+		template<typename View, typename Fn>
+		void each(View&& view, const Time& time, Fn&& fn)
+		{
+			const uint32_t bucket = currentBucket(time);
+			const float now = time.totalTime();
+			auto& clocks = _lastRun[bucket];
+
+			view.each(std::span<const Entity::ID>(_members[bucket]), [&](Entity::ID id, auto&&... components)
+				{
+					float& last = clocks[*_position.try_get(id)];
+					const float dt = now - last;
+					last = now;
+					fn(dt, id, std::forward<decltype(components)>(components)...);
+				});
+		}
+
+	private:
+		std::vector<std::vector<Entity::ID>> _members;	// per bucket, unordered
+		std::vector<std::vector<float>> _lastRun;	// Time::totalTime() of each member's last visit, parallel to _members
+		cstdmf::SparseSet<uint32_t, Entity::ID> _position;	// member -> index in its bucket
+	};
+}
+
+#endif
@@ -65,6 +65,16 @@ namespace csyren::core::details
 			++time._frameCount;
 
 		}
+
+		/// @brief Advances `time` by a fixed step instead of the wall clock (headless simulation).
+		static void step(Time& time, float dt)
+		{
+			time._unscaledDeltaTime = dt;
+			time._unscaledTime += dt;
+			time._deltaTime = dt * time._timeScale;
+			time._time += time._deltaTime;
+			++time._frameCount;
+		}
 	private:
 		Time::Clock_t::time_point _startTime;
 		Time::Clock_t::time_point _lastFrameTime;
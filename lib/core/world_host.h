@@ -0,0 +1,122 @@
+#ifndef __CSYREN_WORLD_HOST__
+#define __CSYREN_WORLD_HOST__
+
+#include "context.h"
+#include "event_bus.h"
+#include "scene.h"
+#include "system_manager.h"
+#include "time.h"
+
+#include "cstdmf/job_system.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace csyren::core
+{
+	/**
+	 * @brief One isolated simulation: its own event bus, scene, systems and clock.
+	 *
+	 * Nothing is shared between worlds, so different worlds can be stepped on
+	 * different threads at the same time. Systems added to a world must not be
+	 * shared with another world.
+	 */
+	class World
+	{
+		friend class WorldHost;
+	public:
+		World() : _scene(_bus) {}
+
+		World(const World&) = delete;
+		World& operator=(const World&) = delete;
+
+		events::EventBus2& bus() noexcept { return _bus; }
+		Scene& scene() noexcept { return _scene; }
+		SystemManager& systems() noexcept { return _systems; }
+		Time& time() noexcept { return _time; }
+		const Time& time() const noexcept { return _time; }
+
+		/// @brief Frame end as in Application::run: play back scene commands, then deliver events.
+		void endFrame()
+		{
+			_scene.flush();
+			_bus.commit_batch();
+		}
+
+	private:
+		events::EventBus2 _bus;
+		Scene _scene;
+		SystemManager _systems;
+		Time _time;
+	};
+
+	/**
+	 * @brief Owns many independent worlds (e.g. one per match) and steps them in parallel.
+	 *
+	 * Each world is one job; its frame runs start to finish on a single thread,
+	 * so world code needs no locking. Worlds may be created or destroyed only
+	 * between ticks. Work a world hands to the host's JobSystem during its tick
+	 * (parallelFor, EventBus2::commit_batch(jobs)) runs inline on that world's thread.
+	 */
+	class WorldHost
+	{
+	public:
+		explicit WorldHost(cstdmf::JobSystem& jobs) : _jobs(jobs) {}
+
+		WorldHost(const WorldHost&) = delete;
+		WorldHost& operator=(const WorldHost&) = delete;
+
+		World& createWorld()
+		{
+			_worlds.push_back(std::make_unique<World>());
+			return *_worlds.back();
+		}
+
+		void destroyWorld(World& world)
+		{
+			std::erase_if(_worlds, [&world](const auto& w) { return w.get() == &world; });
+		}
+
+		[[nodiscard]] size_t size() const noexcept { return _worlds.size(); }
+		[[nodiscard]] World& operator[](size_t index) noexcept { return *_worlds[index]; }
+
+		/**
+		 * @brief Steps every world once: advance its clock by `dt`, run `step(World&)`, endFrame().
+		 *
+		 * Returns when all worlds finished the step.
+		 */
+		template<typename Fn>
+		void tick(float dt, Fn&& step)
+		{
+			_jobs.parallelFor(_worlds.size(), [&](size_t index)
+				{
+					World& world = *_worlds[index];
+					details::TimeHandler::step(world._time, dt);
+					step(world);
+					world.endFrame();
+				});
+		}
+
+		/**
+		 * @brief tick() running each world's SystemManager::update.
+		 *
+		 * `devices` and `resources` are shared by every world and must only be read
+		 * during the tick.
+		 */
+		void tick(float dt, const input::Devices& devices, render::ResourceManager& resources)
+		{
+			tick(dt, [&](World& world)
+				{
+					events::UpdateEvent event{ devices, world._scene, resources, world._bus, world._time };
+					world._systems.update(event);
+				});
+		}
+
+	private:
+		cstdmf::JobSystem& _jobs;
+		std::vector<std::unique_ptr<World>> _worlds;
+	};
+}
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef __CSYREN_DELEGATE__
+#define __CSYREN_DELEGATE__
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace csyren::cstdmf
+{
+	template<typename Signature>
+	class Delegate;
+
+	/**
+	 * @brief Callable wrapper that allocates only for oversized targets.
+	 *
+	 * Targets of up to kInlineSize bytes with a nothrow move live in an inline
+	 * buffer and never allocate. Larger ones (e.g. a wrapped std::function) are
+	 * boxed on the heap once, at construction; capture less or bind a member to
+	 * stay inline. Mutable lambdas are accepted, as with std::function. A call is
+	 * one indirect jump to a thunk that is specialized for the exact target, so
+	 * member functions bound with bind<&C::method>(obj) are called directly inside
+	 * it. Trivially copyable targets (reference captures, bound members) are
+	 * copied and destroyed without going through a thunk.
+	 * @code
+	 * Delegate<void(int&)> d = [&total](int& v) { total += v; };
+	 * auto m = Delegate<void(int&)>::bind<&Counter::add>(&counter);
+	 * @endcode
+	 */
+	template<typename R, typename... Args>
+	class Delegate<R(Args...)>
+	{
+		enum class Op { Copy, Move, Destroy };
+		using Invoke = R(*)(void*, Args...);
+		using Manage = void(*)(Op, void* dst, void* src);
+	public:
+		static constexpr size_t kInlineSize = 4 * sizeof(void*);
+
+		Delegate() noexcept = default;
+		Delegate(std::nullptr_t) noexcept {}
+
+		template<typename Fn>
+		static constexpr bool fits_inline = sizeof(Fn) <= kInlineSize
+			&& alignof(Fn) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Fn>;
+
+		template<typename F, typename Fn = std::decay_t<F>,
+			typename = std::enable_if_t<!std::is_same_v<Fn, Delegate> && std::is_invocable_r_v<R, Fn&, Args...>>>
+		Delegate(F&& fn)
+		{
+			static_assert(std::is_copy_constructible_v<Fn>, "Delegate: callable must be copyable");
+
+			if constexpr (std::is_pointer_v<Fn> || std::is_member_pointer_v<Fn>)
+			{
+				if (!fn) return;
+			}
+			if constexpr (fits_inline<Fn>)
+			{
+				::new (static_cast<void*>(_storage)) Fn(std::forward<F>(fn));
+				_invoke = [](void* target, Args... args) -> R
+					{
+						return std::invoke(*static_cast<Fn*>(target), std::forward<Args>(args)...);
+					};
+				if constexpr (!std::is_trivially_copyable_v<Fn>)
+					_manage = &manage<Fn>;
+			}
+			else
+			{
+				::new (static_cast<void*>(_storage)) Fn*(new Fn(std::forward<F>(fn)));
+				_invoke = [](void* target, Args... args) -> R
+					{
+						return std::invoke(**static_cast<Fn**>(target), std::forward<Args>(args)...);
+					};
+				_manage = &manageBoxed<Fn>;
+			}
+		}
+
+		/// @brief Delegate calling `(obj->*Method)(args...)`.
+		template<auto Method, typename C>
+		[[nodiscard]] static Delegate bind(C* obj) noexcept
+		{
+			Delegate d;
+			::new (static_cast<void*>(d._storage)) C*(obj);
+			d._invoke = [](void* target, Args... args) -> R
+				{
+					return std::invoke(Method, *static_cast<C**>(target), std::forward<Args>(args)...);
+				};
+			return d;
+		}
+
+		Delegate(const Delegate& other)
+			: _invoke(other._invoke), _manage(other._manage)
+		{
+			if (_manage) _manage(Op::Copy, _storage, const_cast<std::byte*>(other._storage));
+			else std::memcpy(_storage, other._storage, kInlineSize);
+		}
+
+		Delegate(Delegate&& other) noexcept
+			: _invoke(other._invoke), _manage(other._manage)
+		{
+			if (_manage) _manage(Op::Move, _storage, other._storage);
+			else std::memcpy(_storage, other._storage, kInlineSize);
+		}
+
+		Delegate& operator=(const Delegate& other)
+		{
+			if (this != &other)
+			{
+				Delegate copy(other);
+				*this = std::move(copy);
+			}
+			return *this;
+		}
+
+		Delegate& operator=(Delegate&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				_invoke = other._invoke;
+				_manage = other._manage;
+				if (_manage) _manage(Op::Move, _storage, other._storage);
+				else std::memcpy(_storage, other._storage, kInlineSize);
+			}
+			return *this;
+		}
+
+		~Delegate() { reset(); }
+
+		/// @brief Like std::function, const even when the target is a mutable callable.
+		R operator()(Args... args) const
+		{
+			return _invoke(const_cast<std::byte*>(_storage), std::forward<Args>(args)...);
+		}
+
+		[[nodiscard]] explicit operator bool() const noexcept { return _invoke != nullptr; }
+
+		void reset() noexcept
+		{
+			if (_manage) _manage(Op::Destroy, _storage, nullptr);
+			_invoke = nullptr;
+			_manage = nullptr;
+		}
+
+	private:
+		template<typename Fn>
+		static void manage(Op op, void* dst, void* src)
+		{
+			switch (op)
+			{
+			case Op::Copy:		::new (dst) Fn(*static_cast<const Fn*>(src)); break;
+			case Op::Move:		::new (dst) Fn(std::move(*static_cast<Fn*>(src))); break;
+			case Op::Destroy:	static_cast<Fn*>(dst)->~Fn(); break;
+			}
+		}
+
+		// the buffer holds an owning Fn*; a moved-from box is left null
+		template<typename Fn>
+		static void manageBoxed(Op op, void* dst, void* src)
+		{
+			switch (op)
+			{
+			case Op::Copy:		::new (dst) Fn*(new Fn(**static_cast<Fn* const*>(src))); break;
+			case Op::Move:		::new (dst) Fn*(std::exchange(*static_cast<Fn**>(src), nullptr)); break;
+			case Op::Destroy:	delete *static_cast<Fn**>(dst); break;
+			}
+		}
+
+		alignas(std::max_align_t) std::byte _storage[kInlineSize]{};
+		Invoke _invoke{ nullptr };
+		Manage _manage{ nullptr };
+	};
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef __CSYREN_DYNAMIC_BITSET__
+#define __CSYREN_DYNAMIC_BITSET__
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace csyren::cstdmf
+{
+	/**
+	 * @brief Growable bit array indexed by integer keys (e.g. entity IDs).
+	 *
+	 * Bits outside the allocated range read as zero, so test() never allocates.
+	 */
+	class DynamicBitset
+	{
+		using Word = uint64_t;
+		static constexpr size_t kWordBits = 64;
+	public:
+		[[nodiscard]] bool test(size_t bit) const noexcept
+		{
+			const size_t word = bit / kWordBits;
+			return word < _words.size() && (_words[word] >> (bit % kWordBits)) & 1u;
+		}
+
+		void set(size_t bit, bool value = true)
+		{
+			const size_t word = bit / kWordBits;
+			if (word >= _words.size())
+			{
+				if (!value) return;
+				_words.resize(word + 1, 0);
+			}
+			const Word mask = Word{ 1 } << (bit % kWordBits);
+			if (value)	_words[word] |= mask;
+			else		_words[word] &= ~mask;
+		}
+
+		void reset(size_t bit) { set(bit, false); }
+
+		[[nodiscard]] size_t count() const noexcept
+		{
+			size_t total = 0;
+			for (const Word w : _words)
+				total += static_cast<size_t>(std::popcount(w));
+			return total;
+		}
+
+		[[nodiscard]] bool none() const noexcept
+		{
+			for (const Word w : _words)
+				if (w) return false;
+			return true;
+		}
+
+		void clear() noexcept { _words.clear(); }
+
+	private:
+		std::vector<Word> _words;
+	};
+}
+
+#endif
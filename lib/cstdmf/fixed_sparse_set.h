@@ -1,6 +1,8 @@
 #ifndef __CSYREN_FIXED_SPARSE_SET__
 #define __CSYREN_FIXED_SPARSE_SET__
 
+#include "relocatable.h"
+
 #include <queue>
 #include <limits>
 #include <stdexcept>
@@ -62,7 +64,7 @@ namespace csyren::cstdmf
 			if (index != last)
 			{
 				const ID last_id = _dense[last];
-				new(&data[index]) T(std::move(data[last]));
+				relocate_at(&data[index], &data[last]);
 				_dense[index] = last_id;
 				_sparse[last_id] = index;
 			}
@@ -0,0 +1,165 @@
+#ifndef __CSYREN_JOB_SYSTEM__
+#define __CSYREN_JOB_SYSTEM__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace csyren::cstdmf
+{
+	/**
+	 * @brief Fixed pool of worker threads running fork-join batches.
+	 *
+	 * parallelFor() hands out indices through an atomic counter; the calling thread
+	 * takes part in the batch and returns once every index ran. Batches from
+	 * different callers are serialized. The first exception thrown by a job is
+	 * rethrown to the caller after the batch drains. A parallelFor() issued from
+	 * inside one of this pool's jobs runs inline on that thread: waiting for the
+	 * pool there would deadlock on the batch that is already running.
+	 */
+	class JobSystem
+	{
+	public:
+		explicit JobSystem(size_t workers = defaultWorkerCount())
+		{
+			_threads.reserve(workers);
+			for (size_t i = 0; i < workers; ++i)
+				_threads.emplace_back([this] { workerLoop(); });
+		}
+
+		~JobSystem()
+		{
+			{
+				std::lock_guard lock(_mutex);
+				_stop = true;
+			}
+			_wake.notify_all();
+			for (auto& t : _threads)
+				t.join();
+		}
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		/// @brief Calls `fn(i)` for every i in [0, count) across the pool and waits for all of them.
+		void parallelFor(size_t count, const std::function<void(size_t)>& fn)
+		{
+			if (count == 0) return;
+			if (inJob())
+			{
+				for (size_t i = 0; i < count; ++i)
+					fn(i);
+				return;
+			}
+
+			std::lock_guard batchLock(_batchMutex);
+			{
+				std::lock_guard lock(_mutex);
+				_job = &fn;
+				_count = count;
+				_next.store(0, std::memory_order_relaxed);
+				_pending = count;
+				_error = nullptr;
+				++_generation;
+			}
+			_wake.notify_all();
+
+			runJobs();
+
+			std::unique_lock lock(_mutex);
+			_done.wait(lock, [this] { return _pending == 0 && _busy == 0; });
+			_job = nullptr;
+			if (_error)
+				std::rethrow_exception(std::exchange(_error, nullptr));
+		}
+
+		[[nodiscard]] size_t workerCount() const noexcept { return _threads.size(); }
+
+		/// @brief True while the calling thread runs a job of this pool (as a worker or as the batch's caller).
+		[[nodiscard]] bool inJob() const noexcept { return t_running == this; }
+
+		static size_t defaultWorkerCount() noexcept
+		{
+			const unsigned hw = std::thread::hardware_concurrency();
+			return hw > 1 ? hw - 1 : 1;
+		}
+
+	private:
+		void workerLoop()
+		{
+			uint64_t seen = 0;
+			while (true)
+			{
+				{
+					std::unique_lock lock(_mutex);
+					_wake.wait(lock, [&] { return _stop || (_generation != seen && _job); });
+					if (_stop) return;
+					seen = _generation;
+					++_busy;
+				}
+				runJobs();
+				{
+					std::lock_guard lock(_mutex);
+					--_busy;
+				}
+				_done.notify_all();
+			}
+		}
+
+		void runJobs()
+		{
+			const JobSystem* outer = std::exchange(t_running, this);
+			size_t finished = 0;
+			for (size_t i = _next.fetch_add(1, std::memory_order_relaxed); i < _count; i = _next.fetch_add(1, std::memory_order_relaxed))
+			{
+				try
+				{
+					(*_job)(i);
+				}
+				catch (...)
+				{
+					std::lock_guard lock(_mutex);
+					if (!_error) _error = std::current_exception();
+				}
+				++finished;
+			}
+			t_running = outer;
+			if (finished == 0) return;
+
+			bool last = false;
+			{
+				std::lock_guard lock(_mutex);
+				_pending -= finished;
+				last = _pending == 0;
+			}
+			if (last) _done.notify_all();
+		}
+
+		static inline thread_local const JobSystem* t_running{ nullptr };
+
+		std::vector<std::thread> _threads;
+		std::mutex _batchMutex;
+
+		std::mutex _mutex;
+		std::condition_variable _wake;
+		std::condition_variable _done;
+
+		const std::function<void(size_t)>* _job{ nullptr };
+		size_t _count{ 0 };
+		std::atomic<size_t> _next{ 0 };
+		size_t _pending{ 0 };
+		size_t _busy{ 0 };
+		uint64_t _generation{ 0 };
+		std::exception_ptr _error;
+		bool _stop{ false };
+	};
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef __CSYREN_LINEAR_ARENA__
+#define __CSYREN_LINEAR_ARENA__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace csyren::cstdmf
+{
+	/**
+	 * @brief Bump allocator made of fixed-size blocks.
+	 *
+	 * Memory handed out stays at a stable address until reset(); blocks are kept
+	 * across resets so a steady workload stops allocating after warm-up.
+	 * The arena never runs destructors - owners of non-trivial objects must do it.
+	 */
+	class LinearArena
+	{
+		struct Block
+		{
+			std::unique_ptr<std::byte[]> data;
+			size_t capacity{ 0 };
+		};
+	public:
+		explicit LinearArena(size_t blockSize = 64 * 1024) noexcept : _blockSize(blockSize) {}
+
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		LinearArena(LinearArena&&) noexcept = default;
+		LinearArena& operator=(LinearArena&&) noexcept = default;
+
+		[[nodiscard]] void* allocate(size_t size, size_t align)
+		{
+			while (_current < _blocks.size())
+			{
+				if (void* ptr = tryAllocate(_blocks[_current], size, align))
+					return ptr;
+				++_current;
+				_offset = 0;
+			}
+
+			const size_t capacity = size + align > _blockSize ? size + align : _blockSize;
+			_blocks.push_back({ std::make_unique<std::byte[]>(capacity), capacity });
+			_current = _blocks.size() - 1;
+			_offset = 0;
+			return tryAllocate(_blocks[_current], size, align);
+		}
+
+		template<typename T, typename... Args>
+		[[nodiscard]] T* create(Args&&... args)
+		{
+			void* mem = allocate(sizeof(T), alignof(T));
+			return new (mem) T(std::forward<Args>(args)...);
+		}
+
+		/// @brief Rewinds to the first block. Previously returned memory becomes invalid.
+		void reset() noexcept
+		{
+			_current = 0;
+			_offset = 0;
+		}
+
+		[[nodiscard]] size_t capacity() const noexcept
+		{
+			size_t total = 0;
+			for (const auto& b : _blocks)
+				total += b.capacity;
+			return total;
+		}
+
+	private:
+		void* tryAllocate(Block& block, size_t size, size_t align) noexcept
+		{
+			const auto base = reinterpret_cast<std::uintptr_t>(block.data.get());
+			const std::uintptr_t aligned = (base + _offset + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1);
+			const size_t end = static_cast<size_t>(aligned - base) + size;
+			if (end > block.capacity)
+				return nullptr;
+			_offset = end;
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		std::vector<Block> _blocks;
+		size_t _blockSize;
+		size_t _current{ 0 };
+		size_t _offset{ 0 };
+	};
+}
+
+#endif
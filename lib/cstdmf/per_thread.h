@@ -0,0 +1,127 @@
+#ifndef __CSYREN_PER_THREAD__
+#define __CSYREN_PER_THREAD__
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace csyren::cstdmf
+{
+	/**
+	 * @brief One lazily created `T` per calling thread.
+	 *
+	 * local() is lock-free once the calling thread has its instance cached; the mutex
+	 * is only taken the first time a thread touches this container (or after the
+	 * small thread-local cache evicted it). Instances live as long as the container.
+	 * When a thread exits, its instance is handed, contents and all, to the next
+	 * thread that registers, so the container holds one instance per thread alive
+	 * at once: that number is assumed to be bounded (a fixed pool, not one thread
+	 * per task). forEach() visits instances in registration order; it may run while
+	 * other threads call local(), but access to the instances themselves is up to `T`.
+	 */
+	template<typename T>
+	class PerThread
+	{
+		// direct-mapped by uid: one probe, and enough slots for a thread using one
+		// container per event type or world without thrashing
+		static constexpr size_t kCacheSize = 64;
+
+		struct CacheEntry
+		{
+			uint64_t owner{ 0 };
+			T* value{ nullptr };
+		};
+
+		struct Slot
+		{
+			std::thread::id owner;
+			std::weak_ptr<const void> alive;	// expires when `owner` exits
+			std::unique_ptr<T> value;
+		};
+	public:
+		PerThread() noexcept : _uid(nextUid()) {}
+
+		PerThread(const PerThread&) = delete;
+		PerThread& operator=(const PerThread&) = delete;
+
+		[[nodiscard]] T& local()
+		{
+			static thread_local std::array<CacheEntry, kCacheSize> cache{};
+
+			CacheEntry& entry = cache[_uid % kCacheSize];
+			if (entry.owner != _uid)
+				entry = { _uid, acquire() };
+			return *entry.value;
+		}
+
+		template<typename Fn>
+		void forEach(Fn&& fn)
+		{
+			std::lock_guard lock(_mutex);
+			for (auto& slot : _slots)
+				fn(*slot.value);
+		}
+
+		template<typename Fn>
+		void forEach(Fn&& fn) const
+		{
+			std::lock_guard lock(_mutex);
+			for (const auto& slot : _slots)
+				fn(static_cast<const T&>(*slot.value));
+		}
+
+		[[nodiscard]] size_t size() const
+		{
+			std::lock_guard lock(_mutex);
+			return _slots.size();
+		}
+
+	private:
+		static uint64_t nextUid() noexcept
+		{
+			static std::atomic<uint64_t> s_next{ 1 };
+			return s_next.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// shared by every container; destroyed with the thread's other thread_locals
+		static const std::shared_ptr<const void>& threadLifetime()
+		{
+			static thread_local const std::shared_ptr<const void> token = std::make_shared<const char>(0);
+			return token;
+		}
+
+		T* acquire()
+		{
+			const auto self = std::this_thread::get_id();
+			const auto& lifetime = threadLifetime();
+			std::lock_guard lock(_mutex);
+			Slot* vacant = nullptr;
+			for (auto& slot : _slots)
+			{
+				if (slot.owner == self && !slot.alive.expired())
+					return slot.value.get();
+				if (!vacant && slot.alive.expired())
+					vacant = &slot;
+			}
+			if (vacant)
+			{
+				vacant->owner = self;
+				vacant->alive = lifetime;
+				return vacant->value.get();
+			}
+			_slots.push_back({ self, lifetime, std::make_unique<T>() });
+			return _slots.back().value.get();
+		}
+
+		const uint64_t _uid;
+		std::vector<Slot> _slots;
+		mutable std::mutex _mutex;
+	};
+}
+
+#endif
@@ -0,0 +1,309 @@
+#ifndef __CSYREN_RELOCATABLE__
+#define __CSYREN_RELOCATABLE__
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/// std::vector holds no self-pointers unless MSVC checked iterators are on. Says nothing about other containers.
+#if !defined(_ITERATOR_DEBUG_LEVEL) || _ITERATOR_DEBUG_LEVEL == 0
+#define CSYREN_STD_VECTOR_RELOCATABLE 1
+#else
+#define CSYREN_STD_VECTOR_RELOCATABLE 0
+#endif
+
+namespace csyren::cstdmf
+{
+    /**
+     * @brief `T` can be moved to a new address with a raw byte copy, leaving the source dead.
+     *
+     * Defaults to std::is_trivially_copyable. Types that only own heap memory through
+     * a pointer (std::unique_ptr members, ...) are relocatable too and may opt in:
+     * @code
+     * template<> struct csyren::cstdmf::is_trivially_relocatable<MyComponent> : std::true_type {};
+     * @endcode
+     * Do not opt in types that store pointers to themselves or hold a member that
+     * does: libstdc++'s std::string (short-string buffer), std::list and std::map
+     * all point into their own object. std::vector does so only in MSVC debug
+     * builds, so guard opt-ins of types holding one with CSYREN_STD_VECTOR_RELOCATABLE.
+     */
+    template<typename T>
+    struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+    template<typename T>
+    inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+    /// @brief Moves `*src` into raw storage `dst` and ends the lifetime of `*src`.
+    template<typename T>
+    void relocate_at(T* dst, T* src) noexcept(is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>)
+    {
+        if constexpr (is_trivially_relocatable_v<T>)
+        {
+            std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), sizeof(T));
+        }
+        else
+        {
+            ::new (static_cast<void*>(dst)) T(std::move(*src));
+            src->~T();
+        }
+    }
+
+    /// @brief relocate_at over `n` elements; ranges must not overlap unless `T` is trivially relocatable.
+    template<typename T>
+    void relocate_n(T* dst, T* src, size_t n) noexcept(is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>)
+    {
+        if (n == 0 || dst == src) return;
+        if constexpr (is_trivially_relocatable_v<T>)
+        {
+            std::memmove(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+        }
+        else
+        {
+            for (size_t i = 0; i < n; ++i)
+                relocate_at(dst + i, src + i);
+        }
+    }
+
+    /**
+     * @brief Minimal vector for dense component storage.
+     *
+     * Growth, swap-and-pop, bulk append and permutation go through relocate_at /
+     * relocate_n, so trivially relocatable types move with memcpy/memmove and never
+     * run a move constructor or destructor on the way. Like std::vector, growth
+     * copies elements whose move constructor may throw, so a failed grow or
+     * reserve leaves the buffer unchanged.
+     */
+    template<typename T>
+    class DenseBuffer
+    {
+        using Alloc = std::allocator<T>;
+        using Traits = std::allocator_traits<Alloc>;
+    public:
+        DenseBuffer() = default;
+        ~DenseBuffer()
+        {
+            clear();
+            deallocate(_data, _capacity);
+        }
+
+        DenseBuffer(const DenseBuffer&) = delete;
+        DenseBuffer& operator=(const DenseBuffer&) = delete;
+
+        DenseBuffer(DenseBuffer&& other) noexcept
+            : _data(std::exchange(other._data, nullptr)),
+            _size(std::exchange(other._size, 0)),
+            _capacity(std::exchange(other._capacity, 0)) {
+        }
+        DenseBuffer& operator=(DenseBuffer&& other) noexcept
+        {
+            if (this != &other)
+            {
+                clear();
+                deallocate(_data, _capacity);
+                _data = std::exchange(other._data, nullptr);
+                _size = std::exchange(other._size, 0);
+                _capacity = std::exchange(other._capacity, 0);
+            }
+            return *this;
+        }
+
+        template<typename... Args>
+        T& emplace_back(Args&&... args)
+        {
+            if (_size == _capacity)
+            {
+                // construct first: args may alias an element of the old block
+                const size_t newCapacity = grownCapacity(_size + 1);
+                T* block = allocate(newCapacity);
+                try
+                {
+                    ::new (static_cast<void*>(block + _size)) T(std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    deallocate(block, newCapacity);
+                    throw;
+                }
+                try
+                {
+                    transfer(block, _data, _size);
+                }
+                catch (...)
+                {
+                    block[_size].~T();
+                    deallocate(block, newCapacity);
+                    throw;
+                }
+                deallocate(_data, _capacity);
+                _data = block;
+                _capacity = newCapacity;
+            }
+            else
+            {
+                ::new (static_cast<void*>(_data + _size)) T(std::forward<Args>(args)...);
+            }
+            return _data[_size++];
+        }
+
+        void pop_back() noexcept
+        {
+            --_size;
+            _data[_size].~T();
+        }
+
+        /// @brief Replaces element `idx` with the last one and shrinks by one.
+        void swap_remove(size_t idx)
+        {
+            const size_t last = _size - 1;
+            if (idx != last)
+            {
+                if constexpr (is_trivially_relocatable_v<T>)
+                {
+                    _data[idx].~T();
+                    relocate_at(_data + idx, _data + last);
+                    --_size;
+                    return;
+                }
+                else
+                {
+                    _data[idx] = std::move(_data[last]);
+                }
+            }
+            pop_back();
+        }
+
+        void swap_elements(size_t a, size_t b)
+        {
+            if (a == b) return;
+            if constexpr (is_trivially_relocatable_v<T>)
+            {
+                alignas(T) std::byte tmp[sizeof(T)];
+                std::memcpy(tmp, static_cast<void*>(_data + a), sizeof(T));
+                std::memcpy(static_cast<void*>(_data + a), static_cast<const void*>(_data + b), sizeof(T));
+                std::memcpy(static_cast<void*>(_data + b), tmp, sizeof(T));
+            }
+            else
+            {
+                using std::swap;
+                swap(_data[a], _data[b]);
+            }
+        }
+
+        /// @brief Relocates every element of `other` to the end of this buffer; `other` ends up empty.
+        void append(DenseBuffer&& other)
+        {
+            if (other._size == 0) return;
+            reserve(_size + other._size);
+            relocate_n(_data + _size, other._data, other._size);
+            _size += other._size;
+            other._size = 0;
+        }
+
+        /**
+         * @brief Reorders [first, first + n): element at `first + i` becomes old element `order[i]`.
+         *
+         * Every element is relocated once into scratch storage and the block is moved back in one go.
+         */
+        template<typename Index>
+        void permute(size_t first, const Index* order, size_t n)
+        {
+            if (n < 2) return;
+            T* scratch = allocate(n);
+            for (size_t i = 0; i < n; ++i)
+                relocate_at(scratch + i, _data + order[i]);
+            relocate_n(_data + first, scratch, n);
+            deallocate(scratch, n);
+        }
+
+        void reserve(size_t capacity)
+        {
+            if (capacity <= _capacity) return;
+            T* block = allocate(capacity);
+            try
+            {
+                transfer(block, _data, _size);
+            }
+            catch (...)
+            {
+                deallocate(block, capacity);
+                throw;
+            }
+            deallocate(_data, _capacity);
+            _data = block;
+            _capacity = capacity;
+        }
+
+        void clear() noexcept
+        {
+            if constexpr (!std::is_trivially_destructible_v<T>)
+            {
+                for (size_t i = 0; i < _size; ++i)
+                    _data[i].~T();
+            }
+            _size = 0;
+        }
+
+        [[nodiscard]] T& operator[](size_t i) noexcept { return _data[i]; }
+        [[nodiscard]] const T& operator[](size_t i) const noexcept { return _data[i]; }
+        [[nodiscard]] T& back() noexcept { return _data[_size - 1]; }
+
+        [[nodiscard]] T* data() noexcept { return _data; }
+        [[nodiscard]] const T* data() const noexcept { return _data; }
+        [[nodiscard]] size_t size() const noexcept { return _size; }
+        [[nodiscard]] size_t capacity() const noexcept { return _capacity; }
+        [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+
+    private:
+        /// @brief Moves `n` elements into fresh storage; if that can throw, copies instead and destroys the source only on success.
+        static void transfer(T* dst, T* src, size_t n)
+        {
+            if constexpr (is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>
+                || !std::is_copy_constructible_v<T>)
+            {
+                relocate_n(dst, src, n);
+            }
+            else
+            {
+                size_t i = 0;
+                try
+                {
+                    for (; i < n; ++i)
+                        ::new (static_cast<void*>(dst + i)) T(std::as_const(src[i]));
+                }
+                catch (...)
+                {
+                    std::destroy_n(dst, i);
+                    throw;
+                }
+                std::destroy_n(src, n);
+            }
+        }
+
+        size_t grownCapacity(size_t required) const noexcept
+        {
+            const size_t doubled = _capacity ? _capacity * 2 : 8;
+            return doubled > required ? doubled : required;
+        }
+
+        static T* allocate(size_t n)
+        {
+            Alloc alloc;
+            return Traits::allocate(alloc, n);
+        }
+        static void deallocate(T* p, size_t n) noexcept
+        {
+            if (!p) return;
+            Alloc alloc;
+            Traits::deallocate(alloc, p, n);
+        }
+
+        T* _data{ nullptr };
+        size_t _size{ 0 };
+        size_t _capacity{ 0 };
+    };
+}
+
+#endif
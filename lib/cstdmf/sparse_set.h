@@ -1,11 +1,15 @@
 #ifndef __CSYREN_SPARSE_SET__
 #define __CSYREN_SPARSE_SET__
 
+#include "relocatable.h"
+
+#include <algorithm>
 #include <cstdint>
 #include <limits>
 #include <vector>
 #include <memory>
 #include <stdexcept>
+#include <utility>
 
 namespace
 {
@@ -78,16 +82,44 @@ namespace csyren::cstdmf
             {
                 const EntityID movedEntity = _dense[last];
                 _dense[idx] = movedEntity;
-                _items[idx] = std::move(_items[last]);
                 sparseRef(movedEntity) = idx;
             }
 
             _dense.pop_back();
-            _items.pop_back();
+            _items.swap_remove(idx);
             cell = kInvalidIndex;
             return true;
         }
 
+        /**
+         * @brief Moves every element of `other` to the end of this set in one pass.
+         *
+         * Keys are translated through `remap`; dense arrays are spliced as a block
+         * instead of being emplaced element by element. `other` is left empty.
+         */
+        template<typename Remap>
+        void append(SparseSet&& other, Remap&& remap)
+        {
+            if (other.empty()) return;
+
+            const size_t first = _dense.size();
+            for (const EntityID key : other._dense)
+            {
+                if (contains(remap(key)))
+                    throw std::runtime_error("SparseSet::append: entity already present");
+            }
+
+            _dense.reserve(first + other._dense.size());
+            for (const EntityID key : other._dense)
+            {
+                const EntityID mapped = remap(key);
+                sparseRef(mapped) = static_cast<index_type>(_dense.size());
+                _dense.push_back(mapped);
+            }
+            _items.append(std::move(other._items));
+            other.clear();
+        }
+
         [[nodiscard]] bool contains(EntityID entity) const noexcept {
             const auto cell = sparsePtr(entity);
             return cell && *cell != kInvalidIndex;
@@ -152,6 +184,53 @@ namespace csyren::cstdmf
             _items.reserve(capacity);
         }
 
+        /// @brief Dense position of `entity`, or size() when absent.
+        [[nodiscard]] size_t index_of(EntityID entity) const noexcept
+        {
+            const index_type* cell = sparsePtr(entity);
+            return cell && *cell != kInvalidIndex ? *cell : _dense.size();
+        }
+
+        /// @brief Exchanges two dense slots (keys and values) and fixes the sparse cells.
+        void swap_dense(size_t a, size_t b)
+        {
+            if (a == b) return;
+            using std::swap;
+            swap(_dense[a], _dense[b]);
+            _items.swap_elements(a, b);
+            *sparsePtr(_dense[a]) = static_cast<index_type>(a);
+            *sparsePtr(_dense[b]) = static_cast<index_type>(b);
+        }
+
+        /**
+         * @brief Sorts the dense range [first, last) by `compare(const T&, const T&)`.
+         *
+         * Only an index array is sorted; elements are then relocated once each
+         * (memcpy for trivially relocatable types) instead of being swapped around.
+         */
+        template<typename Compare>
+        void sort(Compare compare, size_t first = 0, size_t last = std::numeric_limits<size_t>::max())
+        {
+            last = std::min(last, _dense.size());
+            if (last <= first + 1) return;
+
+            std::vector<index_type> order(last - first);
+            for (size_t i = 0; i < order.size(); ++i)
+                order[i] = static_cast<index_type>(first + i);
+            std::stable_sort(order.begin(), order.end(),
+                [&](index_type a, index_type b) { return compare(std::as_const(_items[a]), std::as_const(_items[b])); });
+
+            std::vector<EntityID> keys(order.size());
+            for (size_t i = 0; i < order.size(); ++i)
+                keys[i] = _dense[order[i]];
+            _items.permute(first, order.data(), order.size());
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                _dense[first + i] = keys[i];
+                sparseRef(keys[i]) = static_cast<index_type>(first + i);
+            }
+        }
+
         T* data() noexcept { return _items.data(); };
         const T* data() const noexcept { return _items.data(); };
 
@@ -189,7 +268,147 @@ namespace csyren::cstdmf
 
         std::vector<std::unique_ptr<index_type[]>> _sparsePages;
         std::vector<EntityID>                    _dense;
-        std::vector<T>                           _items;
+        DenseBuffer<T>                           _items;
+    };
+
+    /**
+     * @brief Key-only sparse set: membership and dense key order, no per-element storage.
+     */
+    template<typename EntityID>
+    class SparseSet<void, EntityID>
+    {
+        static_assert(std::is_integral_v<EntityID>, "EntityID should be integer type.");
+        using index_type = EntityID;
+        static constexpr index_type     kInvalidIndex = static_cast<index_type>(-1);
+    public:
+        SparseSet() = default;
+
+        SparseSet(const SparseSet&) = delete;
+        SparseSet& operator=(const SparseSet&) = delete;
+
+        SparseSet(SparseSet&&) noexcept = default;
+        SparseSet& operator=(SparseSet&&) noexcept = default;
+
+        bool emplace(EntityID entity)
+        {
+            index_type& cell = sparseRef(entity);
+            if (cell != kInvalidIndex)
+                throw std::runtime_error("SparseSet::emplace: entity already present");
+
+            cell = static_cast<index_type>(_dense.size());
+            _dense.push_back(entity);
+            return true;
+        }
+
+        bool erase(EntityID entity) noexcept
+        {
+            index_type* cell = sparsePtr(entity);
+            if (!cell || *cell == kInvalidIndex)
+                return false;
+
+            const index_type idx = *cell;
+            const EntityID movedEntity = _dense.back();
+            _dense[idx] = movedEntity;
+            *sparsePtr(movedEntity) = idx;
+
+            _dense.pop_back();
+            *cell = kInvalidIndex;
+            return true;
+        }
+
+        template<typename Remap>
+        void append(SparseSet&& other, Remap&& remap)
+        {
+            for (const EntityID key : other._dense)
+            {
+                if (contains(remap(key)))
+                    throw std::runtime_error("SparseSet::append: entity already present");
+            }
+
+            _dense.reserve(_dense.size() + other._dense.size());
+            for (const EntityID key : other._dense)
+            {
+                const EntityID mapped = remap(key);
+                sparseRef(mapped) = static_cast<index_type>(_dense.size());
+                _dense.push_back(mapped);
+            }
+            other.clear();
+        }
+
+        [[nodiscard]] bool contains(EntityID entity) const noexcept
+        {
+            const index_type* cell = sparsePtr(entity);
+            return cell && *cell != kInvalidIndex;
+        }
+
+        using key_iterator = typename std::vector<EntityID>::iterator;
+        using const_key_iterator = typename std::vector<EntityID>::const_iterator;
+
+        [[nodiscard]] size_t        size() const noexcept { return _dense.size(); }
+        [[nodiscard]] bool          empty() const noexcept { return _dense.empty(); }
+
+        [[nodiscard]] key_iterator       key_begin() noexcept { return _dense.begin(); }
+        [[nodiscard]] key_iterator       key_end()   noexcept { return _dense.end(); }
+        [[nodiscard]] const_key_iterator key_begin() const noexcept { return  _dense.begin(); }
+        [[nodiscard]] const_key_iterator key_end()   const noexcept { return  _dense.end(); }
+
+        EntityID* key_data() noexcept { return _dense.data(); };
+        const EntityID* key_data() const noexcept { return _dense.data(); };
+
+        /// Invalidates only the cells in use, so pages are kept for reuse.
+        void clear() noexcept
+        {
+            for (const EntityID key : _dense)
+                *sparsePtr(key) = kInvalidIndex;
+            _dense.clear();
+        }
+
+        void reserve(size_t capacity) { _dense.reserve(capacity); }
+
+        [[nodiscard]] size_t index_of(EntityID entity) const noexcept
+        {
+            const index_type* cell = sparsePtr(entity);
+            return cell && *cell != kInvalidIndex ? *cell : _dense.size();
+        }
+
+        void swap_dense(size_t a, size_t b)
+        {
+            if (a == b) return;
+            std::swap(_dense[a], _dense[b]);
+            *sparsePtr(_dense[a]) = static_cast<index_type>(a);
+            *sparsePtr(_dense[b]) = static_cast<index_type>(b);
+        }
+
+    private:
+        [[nodiscard]] index_type* sparsePtr(EntityID entity) noexcept
+        {
+            const size_t page = entity >> kPageBits;
+            if (page >= _sparsePages.size() || !_sparsePages[page])
+                return nullptr;
+            return &_sparsePages[page][entity & kPageMask];
+        }
+        [[nodiscard]] const index_type* sparsePtr(EntityID entity) const noexcept
+        {
+            const size_t page = entity >> kPageBits;
+            if (page >= _sparsePages.size() || !_sparsePages[page])
+                return nullptr;
+            return &_sparsePages[page][entity & kPageMask];
+        }
+        index_type& sparseRef(EntityID entity)
+        {
+            const size_t page = entity >> kPageBits;
+            if (page >= _sparsePages.size())
+                _sparsePages.resize(page + 1);
+            if (!_sparsePages[page])
+            {
+                _sparsePages[page] = std::make_unique<index_type[]>(kPageSize);
+                std::fill_n(_sparsePages[page].get(), kPageSize, kInvalidIndex);
+            }
+            return _sparsePages[page][entity & kPageMask];
+        }
+
+        std::vector<std::unique_ptr<index_type[]>> _sparsePages;
+        std::vector<EntityID>                    _dense;
     };
 }
 
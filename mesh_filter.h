@@ -5,14 +5,19 @@
 
 namespace csyren::components
 {
+    // ordered so both can be stored as core::Shared<> flyweights
     struct MeshFilter
     {
         render::MeshHandle mesh;
+
+        bool operator<(const MeshFilter& other) const { return mesh < other.mesh; }
     };
 
     struct MeshRenderer
     {
         csyren::render::MaterialHandle material;
+
+        bool operator<(const MeshRenderer& other) const { return material < other.material; }
     };
 }
 
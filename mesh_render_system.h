@@ -9,6 +9,8 @@
 #include "transform.h"
 #include "mesh_filter.h"
 
+#include <span>
+
 
 using namespace csyren::core;
 using namespace csyren::components;
@@ -28,40 +30,68 @@ namespace csyren
             auto perMaterialCB = event.render.getPerMaterialCB();
             auto perEntityBuffer = event.render.getPerEntityBuffer();
 
-            event.scene.view<Transform, MeshFilter, MeshRenderer>()
-                .each([&](Entity::ID id,
-                    Transform& tr,
-                    MeshFilter& mf,
-                    MeshRenderer& mr)
+            UINT perEntityRoot = UINT_MAX;
+            auto bindMaterial = [&](render::MaterialHandle handle)
+                {
+                    auto* material = event.resources.getMaterial(handle);
+                    if (!material) return false;
+                    auto* shader = event.resources.getShader(material->getShader());
+                    if (!shader) return false;
+
+                    cmd->SetPipelineState(material->pso());
+                    cmd->SetGraphicsRootSignature(shader->getRootSignature());
+
+                    auto perFrameRoot = shader->getRootParameterIndex("PerFrame");
+                    perEntityRoot = shader->getRootParameterIndex("PerObject");
+                    if (perFrameRoot != UINT_MAX)
                     {
-                        auto* mesh = event.resources.getMesh(mf.mesh);
-                        auto* material = event.resources.getMaterial(mr.material);
-                        if (!mesh || !material) return;
-                        auto* shader = event.resources.getShader(material->getShader());
-                        if (!shader) return;
-
-                        cmd->SetPipelineState(material->pso());
-                        cmd->SetGraphicsRootSignature(shader->getRootSignature());
-
-                        // Update per-entity constant buffer (world matrix)
-                        perEntityBuffer->world = tr.world();
-                        perEntityCB->update(perEntityBuffer, sizeof(render::PerEntityBuffer));
-                        
-                        auto perFrameRoot = shader->getRootParameterIndex("PerFrame");
-                        auto perEntityRoot = shader->getRootParameterIndex("PerObject");
-                        if (perFrameRoot != UINT_MAX)
-                        {
-                            cmd->SetGraphicsRootConstantBufferView(0, perFrameCB->gpuAddress());
-                        }
+                        cmd->SetGraphicsRootConstantBufferView(0, perFrameCB->gpuAddress());
+                    }
 
-                        if (perEntityRoot != UINT_MAX)
-                        {
-                            cmd->SetGraphicsRootConstantBufferView(1, perEntityCB->gpuAddress());
-                        }
+                    //cmd->SetGraphicsRootConstantBufferView(2, perMaterialCB->gpuAddress());
+                    return true;
+                };
+
+            auto drawMesh = [&](Entity::ID, Transform& tr, MeshFilter& mf)
+                {
+                    auto* mesh = event.resources.getMesh(mf.mesh);
+                    if (!mesh) return;
 
-                        //cmd->SetGraphicsRootConstantBufferView(2, perMaterialCB->gpuAddress());
+                    // Update per-entity constant buffer (world matrix)
+                    perEntityBuffer->world = tr.world();
+                    perEntityCB->update(perEntityBuffer, sizeof(render::PerEntityBuffer));
 
-                        mesh->draw(event.render);
+                    if (perEntityRoot != UINT_MAX)
+                    {
+                        cmd->SetGraphicsRootConstantBufferView(1, perEntityCB->gpuAddress());
+                    }
+
+                    mesh->draw(event.render);
+                };
+
+            // one batch per material: pipeline state and root signature are bound once per group
+            auto drawables = event.scene.view<Transform, MeshFilter>();
+            event.scene.eachGroup<MeshRenderer, Transform, MeshFilter>(
+                [&](const MeshRenderer& mr, std::span<const Entity::ID> entities)
+                {
+                    if (bindMaterial(mr.material))
+                        drawables.each(entities, drawMesh);
+                });
+
+            // plain (unshared) MeshRenderer: rebind only when the material changes
+            bool first = true;
+            bool bound = false;
+            render::MaterialHandle current{};
+            event.scene.view<MeshRenderer, Transform, MeshFilter>()
+                .each([&](Entity::ID id, MeshRenderer& mr, Transform& tr, MeshFilter& mf)
+                    {
+                        if (first || !(mr.material == current))
+                        {
+                            first = false;
+                            current = mr.material;
+                            bound = bindMaterial(current);
+                        }
+                        if (bound) drawMesh(id, tr, mf);
                     });
         }
 
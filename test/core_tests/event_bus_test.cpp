@@ -4,12 +4,22 @@
 #include <vector>
 #include <atomic>
 #include <string>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <iostream>
 
 using namespace csyren::core::events;
 
 struct TestEvent { int value; };
 struct AnotherEvent { float data; };
 struct MarkedEvent { std::string info; };
+struct HitEvent { uint32_t entity; int damage; };
+struct CopyCountedEvent {
+    int copies = 0;
+    CopyCountedEvent() = default;
+    CopyCountedEvent(const CopyCountedEvent& other) : copies(other.copies + 1) {}
+};
 
 class EventBusTest : public ::testing::Test {
 protected:
@@ -314,4 +324,456 @@ TEST_F(EventBusTest, NoSubscribers) {
         bus->publish(pub_token, TestEvent{});
         bus->commit_batch();
         });
-}
\ No newline at end of file
+}
+
+TEST_F(EventBusTest, EntitySubscribersOnlySeeTheirEntity) {
+    auto pub_token = bus->register_publisher<HitEvent>();
+    int damage3 = 0, damage7 = 0, all = 0;
+    auto sub3 = bus->subscribe_entity<HitEvent>(3, [&](HitEvent& e) { damage3 += e.damage; });
+    bus->subscribe_entity<HitEvent>(7, [&](HitEvent& e) { damage7 += e.damage; });
+    bus->subscribe<HitEvent>([&](HitEvent&) { ++all; });
+
+    bus->publish(pub_token, HitEvent{ 3, 10 });
+    bus->publish(pub_token, HitEvent{ 7, 1 });
+    bus->publish(pub_token, HitEvent{ 5, 100 });
+    bus->commit_batch();
+
+    EXPECT_EQ(damage3, 10);
+    EXPECT_EQ(damage7, 1);
+    EXPECT_EQ(all, 3);
+
+    bus->unsubscribe(sub3);
+    bus->publish(pub_token, HitEvent{ 3, 10 });
+    bus->commit_batch();
+    EXPECT_EQ(damage3, 10);
+    EXPECT_EQ(all, 4);
+}
+
+TEST_F(EventBusTest, ContendedPublishBenchmark) {
+    constexpr int kEventsPerThread = 20000;
+    auto pub_token = bus->register_publisher<TestEvent>();
+    std::atomic<int64_t> received = 0;
+    int64_t sum = 0;
+    bus->subscribe<TestEvent>([&](TestEvent& e) { ++received; sum += e.value; });
+
+    for (int threads : { 1, 4, 16 }) {
+        received = 0;
+        sum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; ++t) {
+            producers.emplace_back([&] {
+                for (int i = 0; i < kEventsPerThread; ++i)
+                    bus->publish(pub_token, TestEvent{ i });
+                });
+        }
+        for (auto& producer : producers) producer.join();
+        const auto published = std::chrono::steady_clock::now();
+        bus->commit_batch();
+        const auto committed = std::chrono::steady_clock::now();
+
+        std::cout << threads << " publishing threads: publish "
+            << std::chrono::duration_cast<std::chrono::microseconds>(published - start).count() << "us, commit "
+            << std::chrono::duration_cast<std::chrono::microseconds>(committed - published).count() << "us\n";
+
+        EXPECT_EQ(received, int64_t(threads) * kEventsPerThread);
+        EXPECT_EQ(sum, int64_t(threads) * kEventsPerThread * (kEventsPerThread - 1) / 2);
+    }
+}
+
+TEST_F(EventBusTest, RegistriesGrowOnDemand) {
+    // no fixed 64K publisher table inside the bus any more
+    EXPECT_LT(sizeof(EventBus2), 16u * 1024u);
+
+    int received = 0;
+    bus->subscribe<TestEvent>([&](TestEvent& e) { received += e.value; });
+    std::vector<PublishToken> tokens;
+    for (int i = 0; i < 1000; ++i)
+        tokens.push_back(bus->register_publisher<TestEvent>());
+    for (auto& token : tokens)
+        bus->publish(token, TestEvent{ 1 });
+    bus->commit_batch();
+    EXPECT_EQ(received, 1000);
+}
+
+TEST_F(EventBusTest, EventsPublishedDuringCommitWaitForNextBatch) {
+    auto pub_test = bus->register_publisher<TestEvent>();
+    auto pub_another = bus->register_publisher<AnotherEvent>();
+    int tests = 0, anothers = 0;
+    bus->subscribe<TestEvent>([&](TestEvent& e) {
+        ++tests;
+        if (e.value > 0) bus->publish(pub_test, TestEvent{ e.value - 1 });
+        });
+    bus->subscribe<AnotherEvent>([&](AnotherEvent&) { ++anothers; });
+
+    bus->publish(pub_test, TestEvent{ 2 });
+    bus->commit_batch();
+    EXPECT_EQ(tests, 1);
+    EXPECT_EQ(anothers, 0);
+
+    bus->publish(pub_another, AnotherEvent{});
+    bus->commit_batch();
+    bus->commit_batch();
+    EXPECT_EQ(tests, 3);
+    EXPECT_EQ(anothers, 1);
+
+    bus->commit_batch();
+    EXPECT_EQ(tests, 3);
+}
+
+TEST_F(EventBusTest, MarkerBucketsKeepSubscriptionOrder) {
+    const EventMarker MARK_A = 1, MARK_B = 2;
+    auto pub_a = bus->register_publisher<TestEvent>(MARK_A);
+    auto pub_b = bus->register_publisher<TestEvent>(MARK_B);
+    auto pub_any = bus->register_publisher<TestEvent>();
+    std::vector<int> calls;
+
+    bus->subscribe<TestEvent>(MARK_A, [&](TestEvent&) { calls.push_back(1); });
+    auto wildcard = bus->subscribe<TestEvent>([&](TestEvent&) { calls.push_back(2); });
+    bus->subscribe<TestEvent>(MARK_B, [&](TestEvent&) { calls.push_back(3); });
+    bus->subscribe<TestEvent>(MARK_A, [&](TestEvent&) { calls.push_back(4); });
+
+    bus->publish(pub_a, TestEvent{});
+    bus->commit_batch();
+    EXPECT_EQ(calls, (std::vector<int>{ 1, 2, 4 }));
+
+    calls.clear();
+    bus->publish(pub_any, TestEvent{});
+    bus->commit_batch();
+    EXPECT_EQ(calls, (std::vector<int>{ 1, 2, 3, 4 }));
+
+    // buckets are rebuilt after unsubscribed entries are erased
+    bus->unsubscribe(wildcard);
+    bus->commit_batch();
+    calls.clear();
+    bus->publish(pub_b, TestEvent{});
+    bus->publish(pub_a, TestEvent{});
+    bus->commit_batch();
+    EXPECT_EQ(calls, (std::vector<int>{ 3, 1, 4 }));
+}
+
+TEST_F(EventBusTest, StaleTokenDoesNotRemoveSlotReuser) {
+    auto pub_token = bus->register_publisher<HitEvent>();
+    int first = 0, second = 0, scoped = 0;
+
+    auto old_token = bus->subscribe<HitEvent>([&](HitEvent&) { ++first; });
+    auto entity_token = bus->subscribe_entity<HitEvent>(4, [&](HitEvent&) { ++scoped; });
+    bus->unsubscribe(old_token);
+    bus->commit_batch(); // compaction frees the slot
+
+    bus->subscribe<HitEvent>([&](HitEvent&) { ++second; });
+    bus->unsubscribe(old_token); // same slot, older generation: no-op
+    bus->unsubscribe(old_token);
+
+    bus->publish(pub_token, HitEvent{ 4, 0 });
+    bus->commit_batch();
+    EXPECT_EQ(first, 0);
+    EXPECT_EQ(second, 1);
+    EXPECT_EQ(scoped, 1);
+
+    bus->unsubscribe(entity_token);
+    bus->publish(pub_token, HitEvent{ 4, 0 });
+    bus->commit_batch();
+    EXPECT_EQ(second, 2);
+    EXPECT_EQ(scoped, 1);
+}
+
+TEST_F(EventBusTest, PerEntitySubscriptionChurn) {
+    auto pub_token = bus->register_publisher<HitEvent>();
+    int hits = 0;
+    std::vector<SubscriberToken> tokens;
+    for (uint32_t round = 0; round < 10; ++round) {
+        for (uint32_t e = 0; e < 1000; ++e)
+            tokens.push_back(bus->subscribe_entity<HitEvent>(e, [&](HitEvent&) { ++hits; }));
+        bus->publish(pub_token, HitEvent{ round, 0 });
+        for (auto& token : tokens)
+            bus->unsubscribe(token);
+        tokens.clear();
+        bus->commit_batch();
+    }
+    EXPECT_EQ(hits, 0);
+}
+
+TEST_F(EventBusTest, ImmediateDeliveryRunsInlineByPriority) {
+    bus->set_delivery<CopyCountedEvent>(Delivery::Immediate);
+    auto pub_token = bus->register_publisher<CopyCountedEvent>();
+    std::vector<int> calls;
+    int copies = -1;
+
+    bus->subscribe<CopyCountedEvent>([&](CopyCountedEvent&) { calls.push_back(0); });
+    bus->subscribe<CopyCountedEvent>([&](CopyCountedEvent& e) { calls.push_back(10); copies = e.copies; }, 10);
+    bus->subscribe<CopyCountedEvent>([&](CopyCountedEvent&) { calls.push_back(-5); }, -5);
+    bus->subscribe<CopyCountedEvent>([&](CopyCountedEvent&) { calls.push_back(1); }, 10);
+
+    CopyCountedEvent event;
+    bus->publish(pub_token, event);
+    // delivered before any commit, highest priority first, on the caller's object
+    EXPECT_EQ(calls, (std::vector<int>{ 10, 1, 0, -5 }));
+    EXPECT_EQ(copies, 0);
+
+    calls.clear();
+    bus->commit_batch();
+    EXPECT_TRUE(calls.empty());
+
+    bus->set_delivery<CopyCountedEvent>(Delivery::Batched);
+    bus->publish(pub_token, event);
+    EXPECT_TRUE(calls.empty());
+    bus->commit_batch();
+    EXPECT_EQ(calls, (std::vector<int>{ 10, 1, 0, -5 }));
+}
+
+TEST_F(EventBusTest, EmptyCallbacksAreRejected) {
+    void (*none)(HitEvent&) = nullptr;
+    EXPECT_FALSE(bus->subscribe<HitEvent>(none).valid());
+    EXPECT_FALSE(bus->subscribe<HitEvent>(3u, EventBus2::Callback_t<HitEvent>{}).valid());
+    EXPECT_FALSE(bus->subscribe_entity<HitEvent>(1, none).valid());
+    EXPECT_FALSE(bus->subscribe_entity<HitEvent>(1, 3u, none).valid());
+
+    int calls = 0;
+    auto live = bus->subscribe_entity<HitEvent>(1, [&](HitEvent&) { ++calls; });
+    EXPECT_TRUE(live.valid());
+    auto pub_token = bus->register_publisher<HitEvent>();
+    bus->publish(pub_token, HitEvent{ 1, 5 });
+    bus->commit_batch();
+    EXPECT_EQ(calls, 1);
+    bus->unsubscribe(SubscriberToken{});
+}
+
+TEST_F(EventBusTest, SubscribingFromCallbackWaitsForNextEvent) {
+    auto pub_token = bus->register_publisher<TestEvent>();
+    int calls = 0;
+    int late_calls = 0;
+    int* pc = &calls;
+
+    bool subscribed = false;
+    bus->subscribe<TestEvent>([&, pc](TestEvent&) {
+        if (!subscribed)
+        {
+            // enough appends to reallocate the subscriber vector under the loop
+            subscribed = true;
+            for (int i = 0; i < 4; ++i)
+                bus->subscribe<TestEvent>([&](TestEvent&) { ++late_calls; }, 5);
+        }
+        ++*pc;
+    });
+
+    bus->publish(pub_token, TestEvent{ 1 });
+    bus->publish(pub_token, TestEvent{ 2 });
+    bus->commit_batch();
+    EXPECT_EQ(calls, 2);
+    EXPECT_EQ(late_calls, 4);   // joined after the first event, not during it
+
+    bus->publish(pub_token, TestEvent{ 3 });
+    bus->commit_batch();
+    EXPECT_EQ(calls, 3);
+    EXPECT_EQ(late_calls, 8);
+}
+
+TEST_F(EventBusTest, EntitySubscribingFromEntityCallbackIsDeferred) {
+    auto pub_token = bus->register_publisher<HitEvent>();
+    std::vector<int> hits(200, 0);
+    bool subscribed = false;
+    bus->subscribe_entity<HitEvent>(1, [&](HitEvent& e) {
+        if (!subscribed)
+        {
+            // grows the entity set and entity 1's own vector while it is being walked
+            subscribed = true;
+            for (uint32_t id = 2; id < 200; ++id)
+                bus->subscribe_entity<HitEvent>(id, [&hits, id](HitEvent&) { ++hits[id]; });
+            for (int i = 0; i < 8; ++i)
+                bus->subscribe_entity<HitEvent>(1, [&hits](HitEvent&) { ++hits[0]; });
+        }
+        ++hits[e.entity];
+    });
+
+    bus->publish(pub_token, HitEvent{ 1, 1 });
+    bus->publish(pub_token, HitEvent{ 7, 1 });
+    bus->commit_batch();
+    EXPECT_EQ(hits[1], 1);
+    EXPECT_EQ(hits[0], 0);  // added after the event that created them
+    EXPECT_EQ(hits[7], 1);  // but in time for the next one
+
+    for (uint32_t id = 1; id < 200; ++id)
+        bus->publish(pub_token, HitEvent{ id, 1 });
+    bus->commit_batch();
+    EXPECT_EQ(hits[0], 8);
+    EXPECT_EQ(hits[1], 2);
+    for (uint32_t id = 2; id < 200; ++id)
+        EXPECT_EQ(hits[id], id == 7 ? 2 : 1);
+}
+
+TEST_F(EventBusTest, UnsubscribingADeferredSubscriberDropsIt) {
+    auto pub_token = bus->register_publisher<TestEvent>();
+    int late_calls = 0;
+    SubscriberToken late;
+    bus->subscribe<TestEvent>([&](TestEvent&) {
+        late = bus->subscribe<TestEvent>([&](TestEvent&) { ++late_calls; });
+        bus->unsubscribe(late);
+    });
+
+    bus->publish(pub_token, TestEvent{ 1 });
+    bus->commit_batch();
+    bus->publish(pub_token, TestEvent{ 2 });
+    bus->commit_batch();
+    EXPECT_EQ(late_calls, 0);
+}
+
+namespace
+{
+    template<int N>
+    struct ParallelEvent { int value; };
+
+    struct ParallelProbe
+    {
+        std::vector<int> seen;
+        std::thread::id thread;
+    };
+
+    // the first event of each type waits (bounded) until every type has started,
+    // which only happens if they are dispatched concurrently
+    template<int N>
+    void setupParallelType(EventBus2& bus, ParallelProbe& probe, std::atomic<int>& started, int types)
+    {
+        bus.set_thread_safe<ParallelEvent<N>>();
+        bus.subscribe<ParallelEvent<N>>([&probe, &started, types](ParallelEvent<N>& e) {
+            if (e.value == 0)
+            {
+                probe.thread = std::this_thread::get_id();
+                started.fetch_add(1);
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+                while (started.load() < types && std::chrono::steady_clock::now() < deadline)
+                    std::this_thread::yield();
+            }
+            probe.seen.push_back(e.value);
+        });
+        auto token = bus.register_publisher<ParallelEvent<N>>();
+        for (int i = 0; i < 500; ++i)
+            bus.publish(token, ParallelEvent<N>{ i });
+    }
+}
+
+TEST_F(EventBusTest, ThreadSafeTypesDispatchInParallel) {
+    csyren::cstdmf::JobSystem jobs(3);
+    ParallelProbe probes[3];
+    std::atomic<int> started{ 0 };
+    setupParallelType<0>(*bus, probes[0], started, 3);
+    setupParallelType<1>(*bus, probes[1], started, 3);
+    setupParallelType<2>(*bus, probes[2], started, 3);
+
+    auto pub_test = bus->register_publisher<TestEvent>();
+    std::thread::id sequential_thread;
+    bus->subscribe<TestEvent>([&](TestEvent&) { sequential_thread = std::this_thread::get_id(); });
+    bus->publish(pub_test, TestEvent{});
+
+    bus->commit_batch(jobs);
+
+    std::vector<int> expected(500);
+    for (int i = 0; i < 500; ++i) expected[i] = i;
+    for (const auto& probe : probes)
+        EXPECT_EQ(probe.seen, expected);
+    EXPECT_EQ(started.load(), 3);
+    // flagged types ran concurrently, so at least two of them left the committing thread
+    const auto caller = std::this_thread::get_id();
+    const auto offThread = std::count_if(std::begin(probes), std::end(probes),
+        [caller](const ParallelProbe& probe) { return probe.thread != caller; });
+    EXPECT_GE(offThread, 2);
+    // types not flagged thread-safe stay on the committing thread
+    EXPECT_EQ(sequential_thread, caller);
+}
+
+TEST_F(EventBusTest, BatchPublishKeepsOrderAndMarkers) {
+    const EventMarker MARK_A = 7;
+    auto pub_plain = bus->register_publisher<TestEvent>();
+    auto pub_a = bus->register_publisher<TestEvent>(MARK_A);
+    std::vector<int> all, marked;
+    bus->subscribe<TestEvent>([&](TestEvent& e) { all.push_back(e.value); });
+    bus->subscribe<TestEvent>(MARK_A, [&](TestEvent& e) { marked.push_back(e.value); });
+
+    std::vector<TestEvent> first{ { 1 }, { 2 }, { 3 } };
+    const std::vector<TestEvent> second{ { 4 }, { 5 } };
+    bus->publish(pub_plain, std::span<TestEvent>(first));
+    bus->publish(pub_a, std::span<const TestEvent>(second));
+    bus->publish(pub_a, TestEvent{ 6 });
+    bus->publish(pub_plain, TestEvent{ 7 });
+    bus->commit_batch();
+
+    EXPECT_EQ(all, (std::vector<int>{ 1, 2, 3, 4, 5, 6, 7 }));
+    EXPECT_EQ(marked, (std::vector<int>{ 1, 2, 3, 4, 5, 6, 7 }));
+
+    // a marked batch skips subscribers of other markers
+    const EventMarker MARK_B = 8;
+    auto pub_b = bus->register_publisher<TestEvent>(MARK_B);
+    all.clear();
+    marked.clear();
+    bus->publish(pub_b, std::span<TestEvent>(first));
+    bus->commit_batch();
+    EXPECT_EQ(all, (std::vector<int>{ 1, 2, 3 }));
+    EXPECT_TRUE(marked.empty());
+}
+
+TEST_F(EventBusTest, StatsCountPerTypeAndBatch) {
+    bus->set_stats_enabled(true);
+    auto pub_test = bus->register_publisher<TestEvent>();
+    auto pub_copy = bus->register_publisher<CopyCountedEvent>();
+    bus->set_delivery<CopyCountedEvent>(Delivery::Immediate);
+    bus->subscribe<TestEvent>([](TestEvent&) {});
+    bus->subscribe<TestEvent>([](TestEvent&) {});
+    bus->subscribe<CopyCountedEvent>([](CopyCountedEvent&) {});
+
+    for (int i = 0; i < 3; ++i)
+        bus->publish(pub_test, TestEvent{ i });
+    bus->publish(pub_copy, CopyCountedEvent{});
+    bus->commit_batch();
+
+    auto test_stats = bus->stats_of<TestEvent>();
+    EXPECT_EQ(test_stats.published_last_batch, 3u);
+    EXPECT_EQ(test_stats.delivered_last_batch, 6u);
+    EXPECT_EQ(test_stats.peak_pending, 3u);
+    auto copy_stats = bus->stats_of<CopyCountedEvent>();
+    EXPECT_EQ(copy_stats.published_last_batch, 1u);
+    EXPECT_EQ(copy_stats.delivered_last_batch, 1u);
+    EXPECT_EQ(copy_stats.peak_pending, 0u);
+
+    // a quiet batch resets the per-batch view but keeps totals
+    bus->publish(pub_test, TestEvent{ 9 });
+    bus->commit_batch();
+    bus->commit_batch();
+    test_stats = bus->stats_of<TestEvent>();
+    EXPECT_EQ(test_stats.published_last_batch, 0u);
+    EXPECT_EQ(test_stats.published_total, 4u);
+    EXPECT_EQ(test_stats.delivered_total, 8u);
+    EXPECT_EQ(test_stats.peak_pending, 3u);
+
+    std::ostringstream csv;
+    bus->dump_stats(csv);
+    const std::string text = csv.str();
+    EXPECT_EQ(text.rfind("type,id,", 0), 0u);
+    EXPECT_EQ(std::count(text.begin(), text.end(), '\n'), 1 + static_cast<long>(bus->stats().size()));
+}
+
+TEST_F(EventBusTest, StatsIgnoreTrafficWhileOffAndTimeNestedDispatchOnce) {
+    auto pub_test = bus->register_publisher<TestEvent>();
+    auto pub_copy = bus->register_publisher<CopyCountedEvent>();
+    bus->set_delivery<CopyCountedEvent>(Delivery::Immediate);
+    bus->subscribe<TestEvent>([&](TestEvent&) { bus->publish(pub_copy, CopyCountedEvent{}); });
+    bus->subscribe<CopyCountedEvent>([](CopyCountedEvent&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    });
+
+    bus->publish(pub_test, TestEvent{ 1 });
+    bus->commit_batch();
+    EXPECT_EQ(bus->stats_of<TestEvent>().delivered_total, 0u);
+    EXPECT_EQ(bus->stats_of<CopyCountedEvent>().delivered_total, 0u);
+
+    bus->set_stats_enabled(true);
+    bus->publish(pub_test, TestEvent{ 2 });
+    bus->commit_batch();
+    auto test_stats = bus->stats_of<TestEvent>();
+    auto copy_stats = bus->stats_of<CopyCountedEvent>();
+    EXPECT_EQ(test_stats.published_total, 1u);
+    EXPECT_EQ(test_stats.delivered_total, 1u);
+    EXPECT_EQ(copy_stats.delivered_total, 1u);
+    // the sleep belongs to the nested immediate type, not to the commit that published it
+    EXPECT_GE(copy_stats.callback_ms_total, 19.0);
+    EXPECT_LT(test_stats.callback_ms_total, 10.0);
+}
@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "core/event_replayer.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace csyren::core::events;
+
+namespace
+{
+    struct MoveEvent { int x; int y; };
+    struct FireEvent { uint32_t entity; float power; };
+    struct ChatEvent { std::string text; };
+
+    constexpr EventMarker kPlayerTwo = 2;
+
+    // subscribes to everything and logs "<type>:<value>@<batch>"
+    struct Log
+    {
+        std::vector<std::string> lines;
+        int batch = 0;
+
+        void attach(EventBus2& bus)
+        {
+            bus.subscribe<MoveEvent>([this](MoveEvent& e) { add("move", e.x * 100 + e.y); });
+            bus.subscribe<FireEvent>(kPlayerTwo, [this](FireEvent& e) { add("fire2", static_cast<int>(e.entity)); });
+            bus.subscribe<ChatEvent>([this](ChatEvent&) { add("chat", 0); });
+        }
+
+        void add(const char* what, int value)
+        {
+            lines.push_back(std::string(what) + ":" + std::to_string(value) + "@" + std::to_string(batch));
+        }
+    };
+}
+
+TEST(EventReplay, ReplayReproducesBatches) {
+    std::stringstream stream;
+    Log original;
+    {
+        EventBus2 bus;
+        EventRecorder recorder(stream);
+        bus.set_recorder(&recorder);
+        original.attach(bus);
+
+        auto move = bus.register_publisher<MoveEvent>();
+        auto fire_one = bus.register_publisher<FireEvent>(1);
+        auto fire_two = bus.register_publisher<FireEvent>(kPlayerTwo);
+        auto chat = bus.register_publisher<ChatEvent>();
+
+        bus.publish(move, MoveEvent{ 1, 2 });
+        bus.publish(fire_one, FireEvent{ 10, 1.0f });
+        bus.publish(chat, ChatEvent{ "gg" });
+        bus.commit_batch();
+        original.batch++;
+
+        std::vector<MoveEvent> path{ { 3, 4 }, { 5, 6 } };
+        bus.publish(move, std::span<MoveEvent>(path));
+        bus.publish(fire_two, FireEvent{ 20, 0.5f });
+        bus.commit_batch();
+        original.batch++;
+
+        EXPECT_EQ(recorder.event_count(), 6u);
+        EXPECT_EQ(recorder.commit_count(), 2u);
+        bus.set_recorder(nullptr);
+    }
+
+    EventBus2 fresh;
+    Log replayed;
+    replayed.attach(fresh);
+    EventReplayer replay(stream);
+    replay.add<MoveEvent>();
+    replay.add<FireEvent>();
+
+    while (replay.replay_batch(fresh))
+        replayed.batch++;
+
+    EXPECT_EQ(replayed.batch, 2);
+    // the string payload cannot be recorded, everything else arrives in the same batches
+    std::vector<std::string> expected = original.lines;
+    std::erase(expected, "chat:0@0");
+    EXPECT_EQ(replayed.lines, expected);
+    EXPECT_EQ(replay.replayed(), 5u);
+    EXPECT_EQ(replay.skipped(), 1u);
+}
+
+TEST(EventReplay, ReplayFollowsDeliveryOrderAndSkipsNestedEvents) {
+    // every move makes a subscriber fire, which is delivered in the next batch
+    auto attachCascade = [](EventBus2& bus, Log& log) {
+        log.attach(bus);
+        auto fire = bus.register_publisher<FireEvent>(kPlayerTwo);
+        bus.subscribe<MoveEvent>([&bus, fire](MoveEvent& e) {
+            bus.publish(fire, FireEvent{ static_cast<uint32_t>(e.x * 100 + e.y), 1.0f });
+        });
+    };
+
+    std::stringstream stream;
+    Log original;
+    size_t recorded = 0;
+    {
+        EventBus2 bus;
+        EventRecorder recorder(stream);
+        bus.set_recorder(&recorder);
+        attachCascade(bus, original);
+
+        // delivery follows the per-thread buffers, not the publish interleaving
+        auto move = bus.register_publisher<MoveEvent>();
+        bus.publish(move, MoveEvent{ 1, 1 });
+        std::thread worker([&] {
+            bus.publish(move, MoveEvent{ 2, 1 });
+            bus.publish(move, MoveEvent{ 2, 2 });
+        });
+        worker.join();
+        bus.publish(move, MoveEvent{ 1, 2 });
+
+        bus.commit_batch();
+        original.batch++;
+        bus.commit_batch();
+        original.batch++;
+        recorded = recorder.event_count();
+        bus.set_recorder(nullptr);
+    }
+    ASSERT_EQ(original.lines.size(), 8u);
+    EXPECT_EQ(recorded, 8u);
+
+    EventBus2 fresh;
+    Log replayed;
+    attachCascade(fresh, replayed);
+    EventReplayer replay(stream);
+    replay.add<MoveEvent>();
+    replay.add<FireEvent>();
+    while (replay.replay_batch(fresh))
+        replayed.batch++;
+
+    // the fires come from the replayed subscriber only, not a second time from the stream
+    EXPECT_EQ(replayed.lines, original.lines);
+    EXPECT_EQ(replay.replayed(), 4u);
+    EXPECT_EQ(replay.skipped(), 4u);
+}
+
+TEST(EventReplay, RejectsForeignStreams) {
+    std::stringstream garbage("not an event stream");
+    EXPECT_THROW(EventReplayer replay(garbage), std::runtime_error);
+}
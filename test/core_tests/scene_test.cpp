@@ -1,8 +1,11 @@
 #include "pch.h"
 #include "core/scene.h"
+#include "core/stagger.h"
 
 #include <random>
 #include <algorithm>
+#include <map>
+#include <thread>
 
 using namespace csyren::core;
 
@@ -28,6 +31,13 @@ protected:
     {
         scene.flush();
     };
+
+    template<typename T>
+    size_t sharedGroupCount()
+    {
+        auto pool = scene.getPool<Shared<T>>();
+        return pool ? pool->groupCount() : 0;
+    }
 };
 
 
@@ -416,4 +426,974 @@ TEST_F(SceneViewHardcoreTest, NeedleInAHaystack)
 
     std::cout << "Needle in a haystack search took: " << duration.count() << "us\n";
     EXPECT_LT(duration.count(), 1000);
-}
\ No newline at end of file
+}
+
+TEST_F(SceneTest, MergeStagingScene) {
+    auto existing = createEntityWithTestComponent();
+
+    auto staging = std::make_unique<StagingWorld>();
+    Scene& section = staging->scene();
+    auto root = section.createEntity();
+    section.addComponent<Position>(root, 1.0f, 2.0f);
+    auto child = section.createEntity(root);
+    section.addComponent<Position>(child, 3.0f, 4.0f);
+    section.addComponent<TestComponent>(child, 7);
+
+    auto remap = scene.merge(section);
+
+    EXPECT_EQ(section.entities().size(), 0);
+    EXPECT_EQ(scene.entities().size(), 3);
+
+    const auto liveRoot = remap[root];
+    const auto liveChild = remap[child];
+    EXPECT_NE(liveRoot, existing);
+    EXPECT_NE(liveChild, existing);
+
+    ASSERT_NE(scene.getComponent<Position>(liveRoot), nullptr);
+    EXPECT_EQ(scene.getComponent<Position>(liveRoot)->x, 1.0f);
+    EXPECT_EQ(scene.getComponent<TestComponent>(liveChild)->value, 7);
+    EXPECT_EQ(scene.getComponent<TestComponent>(existing)->value, 42);
+
+    auto* rootEnt = scene.entities().try_get(liveRoot);
+    ASSERT_NE(rootEnt, nullptr);
+    ASSERT_EQ(rootEnt->childrens.size(), 1);
+    EXPECT_EQ(rootEnt->childrens[0], liveChild);
+    EXPECT_EQ(scene.entities().try_get(liveChild)->parent, liveRoot);
+
+    int count = 0;
+    scene.view<Position, TestComponent>().each([&](auto...) { count++; });
+    EXPECT_EQ(count, 1);
+}
+
+TEST_F(SceneTest, EnqueuedStagingMergesOnFlush) {
+    int created = 0;
+    auto token = bus.subscribe<events::ComponentCreateEvent<Health>>([&](auto&) { created++; });
+
+    auto staging = std::make_unique<StagingWorld>();
+    std::thread worker([&staging] {
+        for (int i = 0; i < 100; ++i)
+            staging->scene().addComponent<Health>(staging->scene().createEntity(), i);
+    });
+    worker.join();
+
+    scene.enqueueMerge(std::move(staging));
+    EXPECT_EQ(scene.entities().size(), 0);
+
+    flush();
+    bus.commit_batch();
+    EXPECT_EQ(scene.entities().size(), 100);
+    EXPECT_EQ(created, 100);
+
+    int sum = 0;
+    scene.view<Health>().each([&](Entity::ID, Health& h) { sum += h.value; });
+    EXPECT_EQ(sum, 99 * 100 / 2);
+    bus.unsubscribe(token);
+}
+
+TEST_F(SceneTest, DeferredCreateAndAdd) {
+    auto parent = scene.createEntity();
+    auto id = scene.createEntityDeferred(parent);
+    scene.addComponentDeferred<TestComponent>(id, 5);
+    scene.addComponentDeferred<Position>(id, 1.0f, 2.0f);
+
+    EXPECT_FALSE(scene.entities().contains(id));
+    EXPECT_EQ(scene.getComponent<TestComponent>(id), nullptr);
+
+    flush();
+
+    ASSERT_TRUE(scene.entities().contains(id));
+    EXPECT_EQ(scene.getComponent<TestComponent>(id)->value, 5);
+    EXPECT_EQ(scene.getComponent<Position>(id)->y, 2.0f);
+    EXPECT_EQ(scene.entities().try_get(id)->parent, parent);
+    EXPECT_EQ(scene.entities().try_get(parent)->childrens.size(), 1);
+}
+
+TEST_F(SceneTest, DeferredReplaceAndSkipDuplicateAdd) {
+    auto id = createEntityWithTestComponent();
+    scene.addComponentDeferred<TestComponent>(id, 1);
+    flush();
+    EXPECT_EQ(scene.getComponent<TestComponent>(id)->value, 42);
+
+    scene.replaceComponentDeferred<TestComponent>(id, 2);
+    flush();
+    EXPECT_EQ(scene.getComponent<TestComponent>(id)->value, 2);
+}
+
+TEST_F(SceneTest, DeferredCommandsDuringIteration) {
+    for (int i = 0; i < 100; ++i)
+        scene.addComponent<Position>(scene.createEntity(), static_cast<float>(i), 0.0f);
+
+    int visited = 0;
+    scene.view<Position>().each([&](Entity::ID id, Position& pos) {
+        visited++;
+        auto spawned = scene.createEntityDeferred();
+        scene.addComponentDeferred<Position>(spawned, pos.x, 1.0f);
+        scene.addComponentDeferred<std::string>(id, "payload that does not fit small string buffer");
+    });
+    EXPECT_EQ(visited, 100);
+    EXPECT_EQ(scene.entities().size(), 100);
+
+    flush();
+    EXPECT_EQ(scene.entities().size(), 200);
+    int count = 0;
+    scene.view<Position>().each([&](auto...) { count++; });
+    EXPECT_EQ(count, 200);
+    count = 0;
+    scene.view<Position, std::string>().each([&](auto...) { count++; });
+    EXPECT_EQ(count, 100);
+}
+
+TEST_F(SceneTest, SetParentRelinks) {
+    auto a = scene.createEntity();
+    auto b = scene.createEntity();
+    auto child = scene.createEntity(a);
+
+    scene.setParentDeferred(child, b);
+    flush();
+
+    EXPECT_TRUE(scene.entities().try_get(a)->childrens.empty());
+    ASSERT_EQ(scene.entities().try_get(b)->childrens.size(), 1);
+    EXPECT_EQ(scene.entities().try_get(child)->parent, b);
+}
+
+TEST_F(SceneTest, SetParentRefusesCycles) {
+    auto root = scene.createEntity();
+    auto mid = scene.createEntity(root);
+    auto leaf = scene.createEntity(mid);
+
+    scene.setParent(root, leaf);
+    scene.setParent(mid, mid);
+    scene.setParentDeferred(root, mid);
+    flush();
+
+    EXPECT_EQ(scene.entities().try_get(root)->parent, Entity::invalidID);
+    EXPECT_EQ(scene.entities().try_get(mid)->parent, root);
+    EXPECT_EQ(scene.entities().try_get(leaf)->parent, mid);
+    EXPECT_TRUE(scene.entities().try_get(leaf)->childrens.empty());
+
+    // moving a subtree sideways is still fine
+    auto other = scene.createEntity();
+    scene.setParent(leaf, other);
+    EXPECT_EQ(scene.entities().try_get(leaf)->parent, other);
+
+    scene.destroyEntity(root);
+    flush();
+    EXPECT_FALSE(scene.entities().contains(root));
+    EXPECT_FALSE(scene.entities().contains(mid));
+    EXPECT_TRUE(scene.entities().contains(leaf));
+}
+
+TEST_F(SceneTest, ParallelDeferredRecording) {
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 500;
+    std::vector<Entity::ID> ids;
+    for (int i = 0; i < kThreads * kPerThread; ++i)
+        ids.push_back(createEntityWithTestComponent());
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        workers.emplace_back([&, t] {
+            for (int i = t * kPerThread; i < (t + 1) * kPerThread; ++i)
+            {
+                if (i % 2 == 0)
+                    scene.destroyEntity(ids[i]);
+                else
+                    scene.addComponentDeferred<Health>(ids[i], i);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    flush();
+    EXPECT_EQ(scene.entities().size(), kThreads * kPerThread / 2);
+
+    std::vector<Entity::ID> healthOrder;
+    scene.view<Health>().each([&](Entity::ID id, Health& h) {
+        EXPECT_EQ(h.value % 2, 1);
+        healthOrder.push_back(id);
+    });
+    EXPECT_EQ(healthOrder.size(), kThreads * kPerThread / 2);
+    // playback order is independent of thread scheduling
+    EXPECT_TRUE(std::is_sorted(healthOrder.begin(), healthOrder.end()));
+}
+
+TEST_F(SceneTest, DeferredCommandsFromSeveralThreadsPlayInStreamOrder) {
+    auto a = scene.createEntity();
+    auto b = scene.createEntity();
+    auto child = scene.createEntity();
+
+    std::thread worker([&] {
+        scene.replaceComponentDeferred<Health>(a, 20);
+        scene.setParentDeferred(child, b);
+    });
+    worker.join();
+
+    // this thread started recording after the worker, so its commands win
+    scene.replaceComponentDeferred<Health>(a, 10);
+    scene.setParentDeferred(child, a);
+    flush();
+
+    ASSERT_NE(scene.getComponent<Health>(a), nullptr);
+    EXPECT_EQ(scene.getComponent<Health>(a)->value, 10);
+    EXPECT_EQ(scene.entities().try_get(child)->parent, a);
+    EXPECT_TRUE(scene.entities().try_get(b)->childrens.empty());
+
+    // streams are ordered by their first command of the frame, not by each command
+    scene.replaceComponentDeferred<Health>(a, 1);
+    std::thread([&] { scene.replaceComponentDeferred<Health>(a, 2); }).join();
+    scene.replaceComponentDeferred<Health>(a, 3);
+    flush();
+    EXPECT_EQ(scene.getComponent<Health>(a)->value, 2);
+}
+
+TEST_F(SceneTest, RacingDeferredReplacesKeepOneValue) {
+    constexpr int kThreads = 8;
+    auto e = scene.createEntity();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t)
+        workers.emplace_back([&, t] { scene.replaceComponentDeferred<Health>(e, t); });
+    for (auto& w : workers) w.join();
+    flush();
+
+    ASSERT_NE(scene.getComponent<Health>(e), nullptr);
+    EXPECT_GE(scene.getComponent<Health>(e)->value, 0);
+    EXPECT_LT(scene.getComponent<Health>(e)->value, kThreads);
+}
+
+TEST_F(SceneTest, DeferredRemoveThenAddKeepsComponent) {
+    auto e = scene.createEntity();
+    scene.addComponent<Health>(e, 1);
+
+    scene.removeComponent<Health>(e);
+    scene.addComponentDeferred<Health>(e, 2);
+    flush();
+
+    ASSERT_NE(scene.getComponent<Health>(e), nullptr);
+    EXPECT_EQ(scene.getComponent<Health>(e)->value, 2);
+
+    // and the other way round
+    scene.replaceComponentDeferred<Health>(e, 3);
+    scene.removeComponent<Health>(e);
+    flush();
+    EXPECT_EQ(scene.getComponent<Health>(e), nullptr);
+}
+
+TEST_F(SceneTest, TagComponentsHaveNoStorage) {
+    struct Player {};
+    std::vector<Entity::ID> players;
+    for (int i = 0; i < 10; ++i)
+    {
+        auto id = scene.createEntity();
+        scene.addComponent<Position>(id, static_cast<float>(i), 0.0f);
+        if (i % 2 == 0)
+        {
+            EXPECT_NE(scene.addComponent<Player>(id), nullptr);
+            players.push_back(id);
+        }
+    }
+
+    EXPECT_NE(scene.getComponent<Player>(players[0]), nullptr);
+    EXPECT_EQ(scene.getComponent<Player>(players[0] + 1), nullptr);
+
+    int count = 0;
+    scene.view<Position, Player>().each([&](Entity::ID id, Position& pos) {
+        EXPECT_EQ(static_cast<int>(pos.x) % 2, 0);
+        count++;
+    });
+    EXPECT_EQ(count, 5);
+
+    count = 0;
+    for (auto [id] : scene.view<Player>())
+    {
+        EXPECT_TRUE(std::find(players.begin(), players.end(), id) != players.end());
+        count++;
+    }
+    EXPECT_EQ(count, 5);
+
+    scene.removeComponent<Player>(players[0]);
+    scene.addComponentDeferred<Player>(players[0] + 1);
+    flush();
+    EXPECT_EQ(scene.getComponent<Player>(players[0]), nullptr);
+    EXPECT_NE(scene.getComponent<Player>(players[0] + 1), nullptr);
+}
+
+TEST_F(SceneViewTest, ExcludeFilter) {
+    std::vector<Entity::ID> ids;
+    scene.view<Position, exclude<Health>>().each([&](Entity::ID id, Position& pos) {
+        ids.push_back(id);
+        EXPECT_EQ(pos.x, 1.0f);
+    });
+    EXPECT_EQ(ids.size(), 1);
+
+    int count = 0;
+    scene.view<Position, exclude<Velocity, Health>>().each([&](auto...) { count++; });
+    EXPECT_EQ(count, 0);
+
+    count = 0;
+    scene.view<exclude<Velocity>>().each([&](Entity::ID) { count++; });
+    EXPECT_EQ(count, 1);
+}
+
+TEST_F(SceneViewTest, OptionalFilter) {
+    int withVelocity = 0;
+    int total = 0;
+    scene.view<Position, optional<Velocity>>().each([&](Entity::ID id, Position& pos, Velocity* vel) {
+        total++;
+        if (vel)
+        {
+            withVelocity++;
+            EXPECT_EQ(vel, scene.getComponent<Velocity>(id));
+        }
+    });
+    EXPECT_EQ(total, 3);
+    EXPECT_EQ(withVelocity, 2);
+
+    struct Missing { int v; };
+    total = 0;
+    scene.view<Position, optional<Missing>>().each([&](Entity::ID, Position&, Missing* m) {
+        EXPECT_EQ(m, nullptr);
+        total++;
+    });
+    EXPECT_EQ(total, 3);
+}
+
+TEST_F(SceneViewTest, OptionalPoolCreatedAfterFirstRunIsSeen) {
+    struct Late { int v; };
+    auto view = scene.view<Position, optional<Late>>();
+    int withLate = 0;
+    view.each([&](Entity::ID, Position&, Late* late) { if (late) withLate++; });
+    EXPECT_EQ(withLate, 0);
+
+    // the reused view picks up the pool created since its last run
+    Entity::ID owner = Entity::invalidID;
+    view.each([&](Entity::ID id, Position&, Late*) { if (owner == Entity::invalidID) owner = id; });
+    scene.addComponent<Late>(owner, 7);
+    view.each([&](Entity::ID id, Position&, Late* late) {
+        if (!late) return;
+        withLate++;
+        EXPECT_EQ(id, owner);
+        EXPECT_EQ(late->v, 7);
+    });
+    EXPECT_EQ(withLate, 1);
+}
+
+TEST_F(SceneViewTest, MixedTermsAndConstIteration) {
+    const auto view = scene.view<optional<Health>, Position, exclude<DummyComponent>, Velocity>();
+    int count = 0;
+    int healthy = 0;
+    for (auto it = view.begin(); it != view.end(); ++it)
+    {
+        auto [id, pos, vel, health] = *it;
+        static_assert(std::is_same_v<decltype(health), const Health*>);
+        EXPECT_GT(vel.dx, 0.0f);
+        if (health) healthy++;
+        count++;
+    }
+    EXPECT_EQ(count, 2);
+    EXPECT_EQ(healthy, 1);
+}
+
+TEST_F(SceneTest, ObserverCollectsAddedAndChanged) {
+    auto& observer = scene.observe<Position, Velocity>(ObserveOn::Added | ObserveOn::Changed);
+
+    auto a = scene.createEntity();
+    scene.addComponent<Position>(a, 1.0f, 1.0f);
+    auto b = scene.createEntity();
+    scene.addComponent<Position>(b, 2.0f, 2.0f);
+    scene.addComponent<Velocity>(b, 1.0f, 1.0f);
+    // filter is checked when drained, so adding Velocity after Position still counts
+    auto c = scene.createEntity();
+    scene.addComponent<Position>(c, 3.0f, 3.0f);
+    scene.addComponentDeferred<Velocity>(c, 1.0f, 1.0f);
+    flush();
+
+    std::vector<Entity::ID> seen;
+    observer.drain([&](Entity::ID id) { seen.push_back(id); });
+    EXPECT_EQ(seen, (std::vector<Entity::ID>{ b, c }));
+    EXPECT_TRUE(observer.empty());
+
+    scene.patch<Position>(b, [](Position& p) { p.x = 10.0f; });
+    scene.markChanged<Position>(a);
+    seen.clear();
+    observer.drain([&](Entity::ID id) { seen.push_back(id); });
+    EXPECT_EQ(seen, (std::vector<Entity::ID>{ b }));
+    EXPECT_EQ(scene.getComponent<Position>(b)->x, 10.0f);
+}
+
+TEST_F(SceneTest, ObserverCollectsRemovedAndDestroyed) {
+    auto& observer = scene.observe<Health>(ObserveOn::Removed);
+    auto a = scene.createEntity();
+    scene.addComponent<Health>(a, 1);
+    auto b = scene.createEntity();
+    scene.addComponent<Health>(b, 2);
+    EXPECT_TRUE(observer.empty());
+
+    scene.removeComponent<Health>(a);
+    scene.destroyEntity(b);
+    flush();
+
+    std::vector<Entity::ID> seen;
+    observer.drain([&](Entity::ID id) { seen.push_back(id); });
+    std::sort(seen.begin(), seen.end());
+    EXPECT_EQ(seen, (std::vector<Entity::ID>{ a, b }));
+
+    auto& other = scene.observe<Health>(ObserveOn::Removed);
+    scene.unobserve(observer);
+    scene.addComponent<Health>(a, 3);
+    scene.removeComponent<Health>(a);
+    flush();
+    // only the remaining observer still hears about Health
+    EXPECT_EQ(other.size(), 1u);
+    EXPECT_TRUE(other.contains(a));
+    scene.unobserve(other);
+}
+
+TEST_F(SceneTest, ObserverReportsRemovalAfterIdRecycling) {
+    auto& removed = scene.observe<Health, Position>(ObserveOn::Removed);
+    auto& added = scene.observe<Health>(ObserveOn::Added);
+    auto old = scene.createEntity();
+    scene.addComponent<Position>(old, 0.0f, 0.0f);
+    scene.addComponent<Health>(old, 1);
+    added.clear();
+
+    scene.destroyEntity(old);
+    flush();
+    auto reused = scene.createEntity();
+    ASSERT_EQ(reused, old);
+    // the new occupant has no Position and got its Health after the old one died
+    scene.addComponent<Health>(reused, 2);
+
+    std::vector<Entity::ID> seen;
+    removed.drain([&](Entity::ID id) { seen.push_back(id); });
+    EXPECT_EQ(seen, (std::vector<Entity::ID>{ old }));
+
+    EXPECT_EQ(added.size(), 1u);
+    seen.clear();
+    added.drain([&](Entity::ID id) { seen.push_back(id); });
+    EXPECT_EQ(seen, (std::vector<Entity::ID>{ reused }));
+}
+
+TEST_F(SceneTest, ObserverReportsNewOccupantOfRecycledId) {
+    auto& added = scene.observe<Health>(ObserveOn::Added);
+    auto& both = scene.observe<Health>(ObserveOn::Added | ObserveOn::Removed);
+    auto old = scene.createEntity();
+    scene.addComponent<Health>(old, 1);
+    scene.destroyEntity(old);
+    flush();
+
+    auto reused = scene.createEntity();
+    ASSERT_EQ(reused, old);
+    scene.addComponent<Health>(reused, 2);
+
+    std::vector<Entity::ID> seen;
+    added.drain([&](Entity::ID id) { seen.push_back(id); });
+    EXPECT_EQ(seen, (std::vector<Entity::ID>{ reused }));
+
+    // the removal of the old entity and the add of the new one
+    seen.clear();
+    both.drain([&](Entity::ID id) { seen.push_back(id); });
+    EXPECT_EQ(seen, (std::vector<Entity::ID>{ old, reused }));
+}
+
+TEST_F(SceneTest, ObserverSkipsDestroyedEntitiesForAddTrigger) {
+    auto& observer = scene.observe<Health>(ObserveOn::Added);
+    auto a = scene.createEntity();
+    scene.addComponent<Health>(a, 1);
+    scene.destroyEntity(a);
+    flush();
+
+    EXPECT_EQ(observer.size(), 1);
+    int count = 0;
+    observer.drain([&](Entity::ID) { count++; });
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(SceneTest, DisabledAndSleepingEntitiesAreSkipped) {
+    std::vector<Entity::ID> ids;
+    for (int i = 0; i < 10; ++i)
+    {
+        auto id = scene.createEntity();
+        scene.addComponent<Position>(id, static_cast<float>(i), 0.0f);
+        scene.addComponent<Health>(id, i);
+        ids.push_back(id);
+    }
+
+    scene.setEnabled(ids[1], false);
+    scene.sleep(ids[2]);
+    scene.sleep(ids[3]);
+    scene.setEnabled(ids[3], false);
+    EXPECT_FALSE(scene.isActive(ids[1]));
+    EXPECT_TRUE(scene.isSleeping(ids[2]));
+    EXPECT_FALSE(scene.isEnabled(ids[3]));
+
+    auto collect = [&](auto view) {
+        std::vector<int> values;
+        view.each([&](Entity::ID, Position&, Health& h) { values.push_back(h.value); });
+        std::sort(values.begin(), values.end());
+        return values;
+    };
+    EXPECT_EQ(collect(scene.view<Position, Health>()), (std::vector<int>{ 0, 4, 5, 6, 7, 8, 9 }));
+    EXPECT_EQ(collect(scene.view<Position, Health>().withInactive()).size(), 10);
+
+    int count = 0;
+    scene.view<exclude<Velocity>>().each([&](Entity::ID) { count++; });
+    EXPECT_EQ(count, 7);
+
+    // waking a disabled entity keeps it inactive
+    scene.wake(ids[3]);
+    scene.wake(ids[2]);
+    scene.setEnabled(ids[1], true);
+    EXPECT_EQ(collect(scene.view<Position, Health>()), (std::vector<int>{ 0, 1, 2, 4, 5, 6, 7, 8, 9 }));
+
+    // components stay attached and reachable while inactive
+    EXPECT_EQ(scene.getComponent<Health>(ids[3])->value, 3);
+}
+
+TEST_F(SceneTest, InactivePartitionSurvivesAddAndRemove) {
+    std::vector<Entity::ID> ids;
+    for (int i = 0; i < 20; ++i)
+    {
+        auto id = scene.createEntity();
+        scene.addComponent<Health>(id, i);
+        ids.push_back(id);
+    }
+    for (int i = 0; i < 20; i += 2)
+        scene.sleep(ids[i]);
+
+    // add to an inactive entity and to an active one
+    scene.addComponent<Position>(ids[0]);
+    scene.addComponent<Position>(ids[1]);
+    scene.addComponentDeferred<Velocity>(ids[2], 1.0f, 1.0f);
+    // remove from both regions
+    scene.removeComponent<Health>(ids[4]);
+    scene.removeComponent<Health>(ids[5]);
+    scene.destroyEntity(ids[6]);
+    scene.destroyEntity(ids[7]);
+    flush();
+
+    std::vector<int> values;
+    scene.view<Health>().each([&](Entity::ID id, Health& h) {
+        EXPECT_TRUE(scene.isActive(id));
+        values.push_back(h.value);
+    });
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(values, (std::vector<int>{ 1, 3, 9, 11, 13, 15, 17, 19 }));
+
+    int positions = 0;
+    scene.view<Position>().each([&](Entity::ID id, Position&) { EXPECT_EQ(id, ids[1]); positions++; });
+    EXPECT_EQ(positions, 1);
+    int velocities = 0;
+    scene.view<Velocity>().each([&](auto...) { velocities++; });
+    EXPECT_EQ(velocities, 0);
+
+    scene.wake(ids[2]);
+    scene.view<Velocity>().each([&](auto...) { velocities++; });
+    EXPECT_EQ(velocities, 1);
+
+    // destroyed IDs are recycled without stale sleeping bits
+    auto recycled = scene.createEntity();
+    EXPECT_TRUE(scene.isActive(recycled));
+}
+
+TEST_F(SceneTest, MergeKeepsInactiveState) {
+    auto staging = std::make_unique<StagingWorld>();
+    auto a = staging->scene().createEntity();
+    staging->scene().addComponent<Health>(a, 1);
+    auto b = staging->scene().createEntity();
+    staging->scene().addComponent<Health>(b, 2);
+    staging->scene().setEnabled(b, false);
+
+    auto remap = scene.merge(staging->scene());
+    EXPECT_FALSE(scene.isEnabled(remap[b]));
+
+    int count = 0;
+    scene.view<Health>().each([&](Entity::ID id, Health& h) { EXPECT_EQ(h.value, 1); count++; });
+    EXPECT_EQ(count, 1);
+}
+
+TEST_F(SceneTest, MergeAfterDestroyRecyclesObservedIds) {
+    auto& removed = scene.observe<Health, Position>(ObserveOn::Removed);
+    auto& added = scene.observe<Health>(ObserveOn::Added);
+    auto old = scene.createEntity();
+    scene.addComponent<Position>(old, 0.0f, 0.0f);
+    scene.addComponent<Health>(old, 1);
+    scene.destroyEntity(old);
+    flush();
+
+    // the merged entity takes over the ID but has no Position
+    auto staging = std::make_unique<StagingWorld>();
+    auto a = staging->scene().createEntity();
+    staging->scene().addComponent<Health>(a, 2);
+    auto remap = scene.merge(staging->scene());
+    ASSERT_EQ(remap[a], old);
+
+    std::vector<Entity::ID> seen;
+    removed.drain([&](Entity::ID id) { seen.push_back(id); });
+    EXPECT_EQ(seen, (std::vector<Entity::ID>{ old }));
+
+    seen.clear();
+    added.drain([&](Entity::ID id) { seen.push_back(id); });
+    EXPECT_EQ(seen, (std::vector<Entity::ID>{ remap[a] }));
+}
+
+TEST_F(SceneTest, IndexTracksAddRemoveAndChange) {
+    auto a = scene.createEntity();
+    scene.addComponent<Health>(a, 1);
+    auto& index = scene.createIndex<Health>(&Health::value);
+    EXPECT_EQ(index.count(1), 1u); // existing components are indexed on creation
+
+    auto b = scene.createEntity();
+    scene.addComponent<Health>(b, 1);
+    auto c = scene.createEntity();
+    scene.addComponentDeferred<Health>(c, 5);
+    flush();
+    EXPECT_EQ(index.count(1), 2u);
+    EXPECT_EQ(index.count(5), 1u);
+
+    scene.patch<Health>(b, [](Health& h) { h.value = 3; });
+    scene.replaceComponentDeferred<Health>(c, 7);
+    flush();
+    EXPECT_EQ(*index.keyOf(b), 3);
+    EXPECT_EQ(index.count(5), 0u);
+
+    std::vector<Entity::ID> hits;
+    index.range(2, 7, [&](int, Entity::ID id) { hits.push_back(id); });
+    EXPECT_EQ(hits, (std::vector<Entity::ID>{ b, c }));
+
+    scene.removeComponent<Health>(a);
+    scene.destroyEntity(c);
+    flush();
+    EXPECT_EQ(index.size(), 1u);
+    EXPECT_EQ(index.keyOf(a), nullptr);
+
+    hits.clear();
+    index.each(3, [&](Entity::ID id) { hits.push_back(id); });
+    EXPECT_EQ(hits, (std::vector<Entity::ID>{ b }));
+
+    scene.dropIndex(index);
+    scene.addComponent<Health>(scene.createEntity(), 3);
+}
+
+TEST_F(SceneTest, IndexSeesMergedComponents) {
+    auto& index = scene.createIndex<Position>([](const Position& p) { return static_cast<int>(p.x) / 10; });
+
+    auto staging = std::make_unique<StagingWorld>();
+    for (int i = 0; i < 30; ++i)
+        staging->scene().addComponent<Position>(staging->scene().createEntity(), static_cast<float>(i), 0.0f);
+    scene.merge(staging->scene());
+
+    EXPECT_EQ(index.size(), 30u);
+    EXPECT_EQ(index.count(1), 10u);
+    index.each(2, [&](Entity::ID id) { EXPECT_GE(scene.getComponent<Position>(id)->x, 20.0f); });
+}
+
+struct RenderKey
+{
+    int mesh;
+    int material;
+    bool operator<(const RenderKey& o) const { return mesh != o.mesh ? mesh < o.mesh : material < o.material; }
+};
+
+// handles are re-pointed by setSharedComponent only, never assigned through a view
+static_assert(std::is_copy_constructible_v<Shared<RenderKey>>);
+static_assert(!std::is_copy_assignable_v<Shared<RenderKey>>);
+
+TEST_F(SceneTest, SharedComponentsStoreEachValueOnce) {
+    std::vector<Entity::ID> ids;
+    for (int i = 0; i < 12; ++i)
+    {
+        auto id = scene.createEntity();
+        scene.addComponent<Shared<RenderKey>>(id, RenderKey{ i % 3, 7 });
+        ids.push_back(id);
+    }
+    EXPECT_EQ(sharedGroupCount<RenderKey>(), 3u);
+    EXPECT_EQ(&scene.getComponent<Shared<RenderKey>>(ids[0])->get(),
+              &scene.getComponent<Shared<RenderKey>>(ids[3])->get());
+
+    // views see the shared value through the handle
+    int visited = 0;
+    scene.view<Shared<RenderKey>>().each([&](Entity::ID id, Shared<RenderKey>& key) {
+        EXPECT_EQ(key->mesh, static_cast<int>(id % 3));
+        visited++;
+    });
+    EXPECT_EQ(visited, 12);
+
+    scene.setSharedComponent(ids[0], RenderKey{ 9, 9 });
+    EXPECT_EQ(sharedGroupCount<RenderKey>(), 4u);
+    scene.setSharedComponent(ids[0], RenderKey{ 1, 7 });
+    EXPECT_EQ(sharedGroupCount<RenderKey>(), 3u); // the singleton group is released
+
+    for (int i = 0; i < 12; i += 3)
+        scene.removeComponent<Shared<RenderKey>>(ids[i]);
+    scene.replaceComponentDeferred<Shared<RenderKey>>(ids[1], RenderKey{ 2, 7 });
+    flush();
+    EXPECT_EQ(scene.getComponent<Shared<RenderKey>>(ids[1])->get().mesh, 2);
+    EXPECT_EQ(sharedGroupCount<RenderKey>(), 2u);
+}
+
+TEST_F(SceneTest, SharedComponentsIterateGroupedBatches) {
+    std::vector<Entity::ID> ids;
+    for (int i = 0; i < 20; ++i)
+    {
+        auto id = scene.createEntity();
+        scene.addComponentDeferred<Shared<RenderKey>>(id, RenderKey{ i % 4, 0 });
+        if (i % 2 == 0) scene.addComponent<Position>(id, static_cast<float>(i), 0.0f);
+        ids.push_back(id);
+    }
+    flush();
+    scene.setEnabled(ids[0], false);
+
+    size_t total = 0;
+    std::vector<int> meshes;
+    scene.eachGroup<RenderKey, Position>([&](const RenderKey& key, std::span<const Entity::ID> batch) {
+        meshes.push_back(key.mesh);
+        for (Entity::ID id : batch)
+        {
+            EXPECT_EQ(scene.getComponent<Shared<RenderKey>>(id)->get().mesh, key.mesh);
+            EXPECT_NE(scene.getComponent<Position>(id), nullptr);
+        }
+        total += batch.size();
+    });
+    std::sort(meshes.begin(), meshes.end());
+    EXPECT_EQ(meshes, (std::vector<int>{ 0, 2 }));
+    EXPECT_EQ(total, 9u);
+
+    // merge re-interns values into the live pool
+    auto staging = std::make_unique<StagingWorld>();
+    auto s = staging->scene().createEntity();
+    staging->scene().addComponent<Shared<RenderKey>>(s, RenderKey{ 0, 0 });
+    auto remap = scene.merge(staging->scene());
+    EXPECT_EQ(&scene.getComponent<Shared<RenderKey>>(remap[s])->get(),
+              &scene.getComponent<Shared<RenderKey>>(ids[4])->get());
+
+    scene.destroyEntity(remap[s]);
+    flush();
+    EXPECT_EQ(sharedGroupCount<RenderKey>(), 4u);
+}
+
+TEST_F(SceneTest, WorkerThreadsSpawnEntities) {
+    // leave some recycled IDs in the free list
+    std::vector<Entity::ID> old;
+    for (int i = 0; i < 64; ++i)
+        old.push_back(scene.createEntity());
+    for (int i = 0; i < 64; i += 2)
+        scene.destroyEntity(old[i]);
+    flush();
+
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 256;
+    std::vector<std::vector<Entity::ID>> spawned(kThreads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < kPerThread; ++i)
+            {
+                const Entity::ID id = scene.createEntityDeferred();
+                scene.addComponentDeferred<Health>(id, t * kPerThread + i);
+                spawned[t].push_back(id);
+            }
+        });
+    }
+    // the main thread keeps creating entities immediately meanwhile
+    std::vector<Entity::ID> direct;
+    for (int i = 0; i < 100; ++i)
+        direct.push_back(scene.createEntity());
+    for (auto& w : workers) w.join();
+
+    std::vector<Entity::ID> all = direct;
+    for (const auto& ids : spawned)
+        all.insert(all.end(), ids.begin(), ids.end());
+    std::sort(all.begin(), all.end());
+    EXPECT_EQ(std::adjacent_find(all.begin(), all.end()), all.end());
+
+    flush();
+    EXPECT_EQ(scene.entities().size(), 32u + 100u + kThreads * kPerThread);
+    for (int t = 0; t < kThreads; ++t)
+    {
+        for (int i = 0; i < kPerThread; ++i)
+            EXPECT_EQ(scene.getComponent<Health>(spawned[t][i])->value, t * kPerThread + i);
+    }
+
+    // reconciled counters keep handing out unused IDs
+    auto next = scene.createEntity();
+    EXPECT_FALSE(std::binary_search(all.begin(), all.end(), next));
+    EXPECT_EQ(std::count(old.begin(), old.end(), next), 0);
+}
+
+TEST_F(SceneTest, RuntimeQueryByFamily) {
+    struct Frozen {};
+    std::vector<Entity::ID> ids;
+    for (int i = 0; i < 12; ++i)
+    {
+        auto id = scene.createEntity();
+        scene.addComponent<Health>(id, i);
+        if (i % 2 == 0) scene.addComponent<Position>(id, static_cast<float>(i), 0.0f);
+        if (i % 3 == 0) scene.addComponent<Frozen>(id);
+        if (i % 4 == 0) scene.addComponent<Velocity>(id, 1.0f, 2.0f);
+        ids.push_back(id);
+    }
+    scene.sleep(ids[10]);
+
+    using reflection::ComponentFamily;
+    const size_t health = ComponentFamily::getID<Health>();
+    const size_t position = ComponentFamily::getID<Position>();
+    const size_t frozen = ComponentFamily::getID<Frozen>();
+    const size_t velocity = ComponentFamily::getID<Velocity>();
+
+    std::vector<int> seen;
+    scene.query().with(position).with(health).without(frozen).optional(velocity)
+        .each([&](Entity::ID id, std::span<void* const> columns) {
+            ASSERT_EQ(columns.size(), 3u);
+            const auto* pos = static_cast<const Position*>(columns[0]);
+            const auto* hp = static_cast<const Health*>(columns[1]);
+            EXPECT_EQ(pos, scene.getComponent<Position>(id));
+            EXPECT_EQ(static_cast<int>(pos->x), hp->value);
+            EXPECT_EQ(columns[2] != nullptr, hp->value % 4 == 0);
+            seen.push_back(hp->value);
+        });
+    std::sort(seen.begin(), seen.end());
+    EXPECT_EQ(seen, (std::vector<int>{ 2, 4, 8 })); // 0 and 6 frozen, 10 asleep
+
+    EXPECT_EQ(scene.query().with(frozen).count(), 4u);
+    EXPECT_EQ(scene.query().without(position).count(), 6u);
+    EXPECT_EQ(scene.query().with(health).withInactive().count(), 12u);
+    EXPECT_EQ(scene.query().with(ComponentFamily::getID<DummyComponent>()).count(), 0u);
+}
+
+TEST_F(SceneTest, StaggeredUpdateVisitsEachEntityOncePerCycle) {
+    constexpr uint32_t K = 4;
+    StaggeredUpdate stagger(K);
+    Time time;
+    for (int i = 0; i < 100; ++i)
+    {
+        auto id = scene.createEntity();
+        scene.addComponent<Position>(id, 0.0f, 0.0f);
+        stagger.add(id, time);
+        stagger.add(id, time);
+    }
+    EXPECT_EQ(stagger.size(), 100u);
+
+    std::map<Entity::ID, int> visits;
+    std::map<Entity::ID, float> lastVisit;
+    std::map<Entity::ID, uint32_t> buckets;
+    size_t perFrameMax = 0;
+    for (int frame = 0; frame < 3 * K; ++frame)
+    {
+        details::TimeHandler::step(time, 0.25f);
+        size_t visited = 0;
+        stagger.each(scene.view<Position>(), time, [&](float dt, Entity::ID id, Position& p) {
+            p.x += dt;
+            visits[id]++;
+            lastVisit[id] = time.totalTime();
+            // bucket assignment never changes between cycles
+            auto it = buckets.emplace(id, stagger.currentBucket(time)).first;
+            EXPECT_EQ(it->second, stagger.currentBucket(time));
+            visited++;
+        });
+        perFrameMax = std::max(perFrameMax, visited);
+    }
+
+    EXPECT_EQ(visits.size(), 100u);
+    EXPECT_LT(perFrameMax, 50u);
+    scene.view<Position>().each([&](Entity::ID id, Position& p) {
+        EXPECT_EQ(visits[id], 3);
+        // every member was added at t = 0, so the dts sum up to its last visit
+        EXPECT_NEAR(p.x, lastVisit[id], 1e-4f);
+        EXPECT_EQ(StaggeredUpdate::bucketOf(id, K), stagger.bucketOf(id));
+    });
+
+    // only members are visited, and only while they still match the view
+    auto outsider = scene.createEntity();
+    scene.addComponent<Position>(outsider, 0.0f, 0.0f);
+    auto removed = visits.begin()->first;
+    auto stripped = std::next(visits.begin())->first;
+    stagger.remove(removed);
+    scene.removeComponent<Position>(stripped);
+    flush();
+    stagger.setBuckets(3);
+    visits.clear();
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        details::TimeHandler::step(time, 0.25f);
+        stagger.each(scene.view<Position>(), time, [&](float, Entity::ID id, Position&) { visits[id]++; });
+    }
+    EXPECT_EQ(visits.size(), 98u);
+    EXPECT_EQ(visits.count(outsider), 0u);
+    EXPECT_EQ(visits.count(removed), 0u);
+    EXPECT_EQ(visits.count(stripped), 0u);
+}
+
+TEST_F(SceneTest, StaggeredUpdateDropsDestroyedMembersBeforeTheirIdIsRecycled) {
+    constexpr uint32_t K = 2;
+    StaggeredUpdate stagger(K);
+    Observer& added = scene.observe<Health>(ObserveOn::Added);
+    Observer& gone = scene.observe<Health>(ObserveOn::Removed);
+    auto sync = [&] {
+        gone.drain([&](Entity::ID id) { stagger.remove(id); });
+        added.drain([&](Entity::ID id) { stagger.add(id, Time{}); });
+    };
+
+    auto member = scene.createEntity();
+    scene.addComponent<Health>(member, 1);
+    scene.addComponent<Position>(member, 0.0f, 0.0f);
+    sync();
+    ASSERT_TRUE(stagger.contains(member));
+
+    scene.destroyEntity(member);
+    flush();
+    // the recycled ID names an entity that never qualified for the stagger
+    auto stranger = scene.createEntity();
+    ASSERT_EQ(stranger, member);
+    scene.addComponent<Position>(stranger, 0.0f, 0.0f);
+    sync();
+    EXPECT_FALSE(stagger.contains(stranger));
+
+    Time time;
+    int visits = 0;
+    for (uint32_t frame = 0; frame < K; ++frame)
+    {
+        details::TimeHandler::step(time, 0.25f);
+        stagger.each(scene.view<Position>(), time, [&](float, Entity::ID, Position&) { visits++; });
+    }
+    EXPECT_EQ(visits, 0);
+}
+
+TEST_F(SceneTest, StaggeredUpdateStartsClockWhenMemberIsAdded) {
+    constexpr uint32_t K = 4;
+    StaggeredUpdate stagger(K);
+    Time time;
+
+    auto early = scene.createEntity();
+    scene.addComponent<Position>(early, 0.0f, 0.0f);
+    stagger.add(early, time);
+
+    // run a full cycle, then add a member in the frame right before its bucket runs again
+    const uint32_t bucket = stagger.bucketOf(early);
+    for (uint32_t frame = 0; frame + 1 < 2 * K + bucket; ++frame)
+    {
+        details::TimeHandler::step(time, 0.25f);
+        stagger.each(scene.view<Position>(), time, [](float, Entity::ID, Position&) {});
+    }
+    ASSERT_EQ((stagger.currentBucket(time) + 1) % K, bucket);
+
+    Entity::ID late = Entity::invalidID;
+    while (late == Entity::invalidID)
+    {
+        auto id = scene.createEntity();
+        scene.addComponent<Position>(id, 0.0f, 0.0f);
+        if (stagger.bucketOf(id) == bucket) late = id;
+    }
+    stagger.add(late, time);
+
+    details::TimeHandler::step(time, 0.25f);
+    std::map<Entity::ID, float> dts;
+    stagger.each(scene.view<Position>(), time, [&](float dt, Entity::ID id, Position&) { dts[id] = dt; });
+
+    ASSERT_EQ(dts.count(late), 1u);
+    // the frame it was added in and this one, not the whole gap since the bucket last ran
+    EXPECT_NEAR(dts[late], 0.5f, 1e-4f);
+    EXPECT_NEAR(dts[early], K * 0.25f, 1e-4f);
+}
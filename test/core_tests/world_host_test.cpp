@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "core/world_host.h"
+
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+using namespace csyren::core;
+using namespace csyren::core::events;
+using namespace csyren::cstdmf;
+
+namespace
+{
+    struct Unit { int hp; };
+    struct Hit { Entity::ID target; int damage; };
+}
+
+TEST(WorldHostTest, TicksIsolatedWorldsInParallel) {
+    JobSystem jobs(4);
+    WorldHost host(jobs);
+
+    constexpr int kWorlds = 32;
+    std::vector<int> hits(kWorlds, 0);
+    for (int w = 0; w < kWorlds; ++w)
+    {
+        World& world = host.createWorld();
+        for (int i = 0; i <= w; ++i)
+            world.scene().addComponent<Unit>(world.scene().createEntity(), 100);
+        world.bus().subscribe<Hit>([&hits, w](Hit&) { hits[w]++; });
+    }
+
+    std::unordered_map<const World*, PublishToken> tokens;
+    for (int w = 0; w < kWorlds; ++w)
+        tokens[&host[w]] = host[w].bus().register_publisher<Hit>();
+
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        host.tick(0.1f, [&](World& world) {
+            const PublishToken token = tokens.at(&world);
+            world.scene().view<Unit>().each([&](Entity::ID id, Unit& u) {
+                u.hp -= 1;
+                world.bus().publish(token, Hit{ id, 1 });
+            });
+            // spawn through the deferred path like a gameplay system would
+            world.scene().addComponentDeferred<Unit>(world.scene().createEntityDeferred(), 100);
+        });
+    }
+
+    for (int w = 0; w < kWorlds; ++w)
+    {
+        World& world = host[w];
+        EXPECT_EQ(world.time().frameCount(), 10u);
+        EXPECT_NEAR(world.time().totalTime(), 1.0f, 1e-4f);
+        EXPECT_EQ(world.scene().entities().size(), static_cast<size_t>(w + 1 + 10));
+        // (w + 1) units for 10 frames plus one new unit per earlier frame
+        EXPECT_EQ(hits[w], (w + 1) * 10 + 45);
+    }
+
+    host.destroyWorld(host[0]);
+    EXPECT_EQ(host.size(), static_cast<size_t>(kWorlds - 1));
+}
+
+TEST(WorldHostTest, WorldsCanCommitTheirBusOnTheHostJobSystem) {
+    JobSystem jobs(2);
+    WorldHost host(jobs);
+
+    constexpr int kWorlds = 8;
+    std::vector<int> hits(kWorlds, 0);
+    std::vector<PublishToken> tokens;
+    for (int w = 0; w < kWorlds; ++w)
+    {
+        World& world = host.createWorld();
+        world.bus().set_thread_safe<Hit>();
+        world.bus().subscribe<Hit>([&hits, w](Hit&) { hits[w]++; });
+        tokens.push_back(world.bus().register_publisher<Hit>());
+    }
+
+    // would deadlock if the nested commit waited for the running tick batch
+    host.tick(0.1f, [&](World& world) {
+        for (int w = 0; w < kWorlds; ++w)
+        {
+            if (&host[w] != &world) continue;
+            world.bus().publish(tokens[w], Hit{ 0, 1 });
+            world.bus().commit_batch(jobs);
+        }
+    });
+
+    for (int w = 0; w < kWorlds; ++w)
+        EXPECT_EQ(hits[w], 1);
+}
+
+TEST(WorldHostTest, BusesDoNotShareSubscriberState) {
+    // two buses created and used concurrently, nothing static involved
+    std::atomic<int> delivered{ 0 };
+    auto run = [&] {
+        auto bus = std::make_unique<EventBus2>();
+        auto token = bus->register_publisher<Hit>();
+        for (int i = 0; i < 200; ++i)
+        {
+            auto sub = bus->subscribe<Hit>([&](Hit&) { delivered++; });
+            bus->publish(token, Hit{ 0, 1 });
+            bus->commit_batch();
+            bus->unsubscribe(sub);
+        }
+    };
+    std::thread a(run), b(run);
+    a.join();
+    b.join();
+    EXPECT_EQ(delivered.load(), 400);
+}
@@ -0,0 +1,99 @@
+#include "pch.h"
+#include "cstdmf/delegate.h"
+
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+
+using namespace csyren::cstdmf;
+
+namespace
+{
+    struct Counter
+    {
+        int total = 0;
+        void add(int& v) { total += v; }
+    };
+
+    int twice(int v) { return v * 2; }
+}
+
+TEST(Delegate, CallsLambdasMembersAndFunctions) {
+    int total = 0;
+    Delegate<void(int&)> lambda = [&total](int& v) { total += v; };
+    int value = 5;
+    lambda(value);
+    EXPECT_EQ(total, 5);
+
+    Counter counter;
+    auto member = Delegate<void(int&)>::bind<&Counter::add>(&counter);
+    member(value);
+    member(value);
+    EXPECT_EQ(counter.total, 10);
+
+    Delegate<int(int)> function = &twice;
+    EXPECT_EQ(function(21), 42);
+
+    Delegate<int(int)> empty;
+    EXPECT_FALSE(empty);
+    EXPECT_TRUE(function);
+}
+
+TEST(Delegate, CopiesAndDestroysNonTrivialCaptures) {
+    auto shared = std::make_shared<std::string>("event");
+    {
+        Delegate<size_t()> a = [shared] { return shared->size(); };
+        EXPECT_EQ(shared.use_count(), 2);
+
+        Delegate<size_t()> b = a;
+        EXPECT_EQ(shared.use_count(), 3);
+
+        Delegate<size_t()> c = std::move(b);
+        EXPECT_EQ(c(), 5u);
+
+        b = c;
+        a.reset();
+        EXPECT_FALSE(a);
+        EXPECT_EQ(b(), 5u);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(Delegate, AcceptsMutableLambdas) {
+    Delegate<int()> next = [n = 0]() mutable { return ++n; };
+    EXPECT_EQ(next(), 1);
+    EXPECT_EQ(next(), 2);
+
+    // copies carry the state at the time of the copy
+    Delegate<int()> copy = next;
+    EXPECT_EQ(copy(), 3);
+    EXPECT_EQ(next(), 3);
+}
+
+TEST(Delegate, BoxesCallablesThatDoNotFitInline) {
+    auto shared = std::make_shared<int>(7);
+    struct Big { std::shared_ptr<int> p; char pad[128]; };
+    {
+        Big big{ shared, {} };
+        Delegate<int()> a = [big] { return *big.p; };
+        static_assert(!Delegate<int()>::fits_inline<decltype(big)>);
+        EXPECT_EQ(a(), 7);
+        EXPECT_EQ(shared.use_count(), 3);
+
+        Delegate<int()> b = a;
+        EXPECT_EQ(shared.use_count(), 4);
+        Delegate<int()> c = std::move(a);
+        EXPECT_EQ(shared.use_count(), 4);
+        EXPECT_EQ(c(), 7);
+        b = std::move(c);
+        EXPECT_EQ(b(), 7);
+        EXPECT_EQ(shared.use_count(), 3);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+
+    // an existing std::function wraps without capturing less
+    std::function<int(int)> fn = [shared](int v) { return v + *shared; };
+    Delegate<int(int)> wrapped = fn;
+    EXPECT_EQ(wrapped(1), 8);
+}
@@ -0,0 +1,27 @@
+#include "pch.h"
+#include "cstdmf/dynamic_bitset.h"
+
+using namespace csyren::cstdmf;
+
+TEST(DynamicBitset, SetTestReset) {
+    DynamicBitset bits;
+    EXPECT_FALSE(bits.test(1000));
+    EXPECT_TRUE(bits.none());
+
+    bits.set(3);
+    bits.set(64);
+    bits.set(1000);
+    EXPECT_TRUE(bits.test(3));
+    EXPECT_TRUE(bits.test(64));
+    EXPECT_TRUE(bits.test(1000));
+    EXPECT_FALSE(bits.test(63));
+    EXPECT_EQ(bits.count(), 3u);
+
+    bits.reset(64);
+    EXPECT_FALSE(bits.test(64));
+    EXPECT_EQ(bits.count(), 2u);
+
+    bits.reset(100000); // out of range reset does not allocate or throw
+    bits.clear();
+    EXPECT_TRUE(bits.none());
+}
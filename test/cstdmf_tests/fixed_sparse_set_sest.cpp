@@ -6,6 +6,7 @@ struct TrackedObj {
     static int count;
     int value;
     explicit TrackedObj(int v = 0) : value(v) { ++count; }
+    TrackedObj(const TrackedObj& other) : value(other.value) { ++count; }
     ~TrackedObj() { --count; }
 };
 int TrackedObj::count = 0;
@@ -0,0 +1,52 @@
+#include "pch.h"
+#include "cstdmf/job_system.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace csyren::cstdmf;
+
+TEST(JobSystem, RunsEveryIndexOnce) {
+    JobSystem jobs(3);
+    for (size_t count : { 0u, 1u, 7u, 1000u })
+    {
+        std::vector<std::atomic<int>> visits(count);
+        jobs.parallelFor(count, [&](size_t i) { visits[i]++; });
+        for (auto& v : visits)
+            EXPECT_EQ(v.load(), 1);
+    }
+}
+
+TEST(JobSystem, RethrowsFirstJobException) {
+    JobSystem jobs(2);
+    std::atomic<int> ran{ 0 };
+    EXPECT_THROW(jobs.parallelFor(50, [&](size_t i) {
+        ran++;
+        if (i == 10) throw std::runtime_error("job failed");
+    }), std::runtime_error);
+    EXPECT_EQ(ran.load(), 50);
+
+    // the pool stays usable afterwards
+    jobs.parallelFor(4, [&](size_t) { ran++; });
+    EXPECT_EQ(ran.load(), 54);
+}
+
+TEST(JobSystem, NestedParallelForRunsInline) {
+    JobSystem jobs(2);
+    EXPECT_FALSE(jobs.inJob());
+
+    std::vector<std::atomic<int>> visits(8 * 8);
+    jobs.parallelFor(8, [&](size_t outer) {
+        EXPECT_TRUE(jobs.inJob());
+        const auto self = std::this_thread::get_id();
+        jobs.parallelFor(8, [&](size_t inner) {
+            EXPECT_EQ(std::this_thread::get_id(), self);
+            visits[outer * 8 + inner]++;
+        });
+    });
+    for (auto& v : visits)
+        EXPECT_EQ(v.load(), 1);
+    EXPECT_FALSE(jobs.inJob());
+}
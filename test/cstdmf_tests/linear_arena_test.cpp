@@ -0,0 +1,49 @@
+#include "pch.h"
+#include "cstdmf/linear_arena.h"
+
+#include <string>
+
+using namespace csyren::cstdmf;
+
+TEST(LinearArena, RespectsAlignment) {
+    LinearArena arena(256);
+    void* a = arena.allocate(1, 1);
+    void* b = arena.allocate(8, 64);
+    EXPECT_NE(a, nullptr);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(b) % 64, 0u);
+}
+
+TEST(LinearArena, GrowsWithStableAddresses) {
+    LinearArena arena(64);
+    std::vector<int*> values;
+    for (int i = 0; i < 100; ++i)
+        values.push_back(arena.create<int>(i));
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(*values[i], i);
+}
+
+TEST(LinearArena, OversizedAllocationGetsOwnBlock) {
+    LinearArena arena(64);
+    void* big = arena.allocate(1024, 16);
+    EXPECT_NE(big, nullptr);
+    EXPECT_GE(arena.capacity(), 1024u);
+}
+
+TEST(LinearArena, ResetReusesBlocks) {
+    LinearArena arena(128);
+    for (int i = 0; i < 64; ++i)
+        (void)arena.allocate(16, 8);
+    const size_t capacity = arena.capacity();
+
+    arena.reset();
+    for (int i = 0; i < 64; ++i)
+        (void)arena.allocate(16, 8);
+    EXPECT_EQ(arena.capacity(), capacity);
+}
+
+TEST(LinearArena, NonTrivialObjects) {
+    LinearArena arena;
+    auto* s = arena.create<std::string>("a string long enough to allocate on the heap");
+    EXPECT_EQ(*s, "a string long enough to allocate on the heap");
+    s->~basic_string();
+}
@@ -0,0 +1,77 @@
+#include "pch.h"
+#include "cstdmf/per_thread.h"
+
+#include <latch>
+#include <thread>
+#include <vector>
+
+using namespace csyren::cstdmf;
+
+TEST(PerThread, SameThreadSameInstance) {
+    PerThread<int> values;
+    int& a = values.local();
+    int& b = values.local();
+    EXPECT_EQ(&a, &b);
+    EXPECT_EQ(values.size(), 1u);
+}
+
+TEST(PerThread, EachThreadGetsOwnInstance) {
+    PerThread<std::vector<int>> values;
+    constexpr int kThreads = 8;
+    constexpr int kPushes = 1000;
+
+    // all threads stay alive until every one has registered, so none inherits another's instance
+    std::latch registered(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back([&values, &registered, t] {
+            (void)values.local();
+            registered.arrive_and_wait();
+            for (int i = 0; i < kPushes; ++i)
+                values.local().push_back(t);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    EXPECT_EQ(values.size(), static_cast<size_t>(kThreads));
+    size_t total = 0;
+    values.forEach([&](const std::vector<int>& v) {
+        total += v.size();
+        for (int x : v) EXPECT_EQ(x, v.front());
+    });
+    EXPECT_EQ(total, static_cast<size_t>(kThreads * kPushes));
+}
+
+TEST(PerThread, ManyContainersOnOneThread) {
+    // more containers than cache slots: evicted entries must resolve to the same instance
+    std::vector<std::unique_ptr<PerThread<int>>> containers;
+    for (int i = 0; i < 16; ++i)
+        containers.push_back(std::make_unique<PerThread<int>>());
+
+    for (int round = 0; round < 3; ++round)
+        for (auto& c : containers)
+            ++c->local();
+
+    for (auto& c : containers)
+    {
+        EXPECT_EQ(c->size(), 1u);
+        EXPECT_EQ(c->local(), 3);
+    }
+}
+
+TEST(PerThread, ExitedThreadsHandTheirInstanceOver) {
+    PerThread<std::vector<int>> values;
+    for (int t = 0; t < 20; ++t)
+        std::thread([&values, t] { values.local().push_back(t); }).join();
+
+    // one thread at a time: every thread reused the instance of the one before
+    EXPECT_EQ(values.size(), 1u);
+    values.forEach([](const std::vector<int>& v) { EXPECT_EQ(v.size(), 20u); });
+
+    // a live thread keeps its own instance
+    std::vector<int>& mine = values.local();
+    std::thread([&values, &mine] { EXPECT_NE(&values.local(), &mine); }).join();
+    EXPECT_EQ(&values.local(), &mine);
+    EXPECT_EQ(values.size(), 2u);
+}
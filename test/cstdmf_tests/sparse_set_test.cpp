@@ -174,4 +174,137 @@ TEST(SparseSet, IteratorStability) {
     EXPECT_TRUE(it == s.begin());
     std::vector<int> vec{ s.begin(), s.end() };
     EXPECT_EQ(vec.size(), 2u);
-}
\ No newline at end of file
+}
+TEST(SparseSet, AppendRemapsKeys) {
+    SparseSet<MoveOnly> a;
+    SparseSet<MoveOnly> b;
+    a.emplace(0, 10);
+    b.emplace(0, 20);
+    b.emplace(3, 30);
+
+    a.append(std::move(b), [](EntityID e) { return e + 100; });
+
+    EXPECT_TRUE(b.empty());
+    EXPECT_EQ(a.size(), 3u);
+    EXPECT_EQ(a.try_get(0)->value, 10);
+    EXPECT_EQ(a.try_get(100)->value, 20);
+    EXPECT_EQ(a.try_get(103)->value, 30);
+    EXPECT_FALSE(a.contains(3));
+}
+
+TEST(SparseSet, AppendRejectsDuplicates) {
+    SparseSet<int> a;
+    SparseSet<int> b;
+    a.emplace(7, 1);
+    b.emplace(7, 2);
+    EXPECT_THROW(a.append(std::move(b), [](EntityID e) { return e; }), std::runtime_error);
+    EXPECT_EQ(a.size(), 1u);
+    EXPECT_EQ(*a.try_get(7), 1);
+}
+
+TEST(SparseSet, KeyOnlySet) {
+    SparseSet<void> s;
+    EXPECT_TRUE(s.emplace(3));
+    EXPECT_TRUE(s.emplace(9000));
+    EXPECT_TRUE(s.emplace(5));
+    EXPECT_THROW(s.emplace(5), std::runtime_error);
+    EXPECT_EQ(s.size(), 3u);
+
+    EXPECT_TRUE(s.erase(3));
+    EXPECT_FALSE(s.erase(3));
+    EXPECT_FALSE(s.contains(3));
+    EXPECT_TRUE(s.contains(9000));
+    EXPECT_TRUE(s.contains(5));
+    EXPECT_EQ(*s.key_begin(), 5u);
+
+    SparseSet<void> other;
+    other.emplace(1);
+    s.append(std::move(other), [](EntityID e) { return e + 10; });
+    EXPECT_TRUE(s.contains(11));
+    EXPECT_EQ(s.size(), 3u);
+}
+
+struct CountedMoves {
+    static inline int moves = 0;
+    explicit CountedMoves(int v = 0) : value(v) {}
+    CountedMoves(CountedMoves&& o) noexcept : value(o.value), payload(std::move(o.payload)) { ++moves; }
+    CountedMoves& operator=(CountedMoves&& o) noexcept { value = o.value; payload = std::move(o.payload); ++moves; return *this; }
+    int value;
+    std::vector<int> payload{ 1, 2, 3 };
+};
+template<>
+struct csyren::cstdmf::is_trivially_relocatable<CountedMoves> : std::true_type {};
+
+TEST(SparseSet, RelocatableTypesSkipMoveConstructor) {
+    CountedMoves::moves = 0;
+    {
+        SparseSet<CountedMoves> s;
+        for (EntityID e = 0; e < 100; ++e)
+            s.emplace(e, static_cast<int>(e));
+        s.erase(3);
+        s.swap_dense(0, 1);
+
+        SparseSet<CountedMoves> other;
+        other.emplace(500, 500);
+        s.append(std::move(other), [](EntityID e) { return e; });
+        s.sort([](const CountedMoves& a, const CountedMoves& b) { return a.value > b.value; });
+
+        EXPECT_EQ(CountedMoves::moves, 0);
+        EXPECT_EQ(s[99].value, 99);
+        EXPECT_EQ(s[99].payload.size(), 3u);
+        EXPECT_EQ(s.data()[0].value, 500);
+    }
+}
+
+struct ThrowingMove {
+    static inline int copiesLeft = 0;
+    explicit ThrowingMove(int v) : value(v) {}
+    ThrowingMove(const ThrowingMove& o) : value(o.value) {
+        if (copiesLeft-- == 0) throw std::runtime_error("copy");
+    }
+    ThrowingMove(ThrowingMove&& o) : value(o.value) { o.value = -1; }
+    ThrowingMove& operator=(const ThrowingMove&) = default;
+    ThrowingMove& operator=(ThrowingMove&&) = default;
+    int value;
+};
+
+TEST(DenseBuffer, FailedGrowthLeavesElementsIntact) {
+    DenseBuffer<ThrowingMove> buf;
+    buf.reserve(4);
+    for (int i = 0; i < 4; ++i)
+        buf.emplace_back(i);
+
+    // the move constructor may throw, so growth copies and fails on the third copy
+    ThrowingMove::copiesLeft = 2;
+    EXPECT_THROW(buf.emplace_back(4), std::runtime_error);
+    ThrowingMove::copiesLeft = 2;
+    EXPECT_THROW(buf.reserve(64), std::runtime_error);
+    ASSERT_EQ(buf.size(), 4u);
+    EXPECT_EQ(buf.capacity(), 4u);
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(buf[i].value, i);
+
+    ThrowingMove::copiesLeft = 100;
+    buf.emplace_back(4);
+    ASSERT_EQ(buf.size(), 5u);
+    for (int i = 0; i < 5; ++i)
+        EXPECT_EQ(buf[i].value, i);
+}
+
+TEST(SparseSet, SortKeepsKeysAndLifetimes) {
+    RefCount::alive = 0;
+    {
+        SparseSet<std::pair<int, RefCount>> s;
+        for (EntityID e = 0; e < 10; ++e)
+            s.emplace(e * 7, static_cast<int>((e * 3) % 10), RefCount{});
+        EXPECT_EQ(RefCount::alive, 10);
+
+        s.sort([](const auto& a, const auto& b) { return a.first < b.first; }, 2, 8);
+        EXPECT_EQ(RefCount::alive, 10);
+        for (size_t i = 3; i < 8; ++i)
+            EXPECT_LE(s.data()[i - 1].first, s.data()[i].first);
+        for (EntityID e = 0; e < 10; ++e)
+            EXPECT_EQ(s[e * 7].first, static_cast<int>((e * 3) % 10));
+    }
+    EXPECT_EQ(RefCount::alive, 0);
+}